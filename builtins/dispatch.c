@@ -28,9 +28,22 @@
 // during ISPC build time.
 #include "isa.h"
 #include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
 
 static atomic_int __system_best_isa = -1;
 
+// The maximal ISA that the dispatch functions may use, set with
+// ISPCSetDispatchMaxISA(), or -1 if it is not set. Unlike the rest of this
+// module, it and the ISPCSetDispatchMaxISA/ISPCGetDispatchISA functions are
+// shared by the dispatch code of all the translation units of the program:
+// builtins.cpp::LinkDispatcher turns them into weak definitions.
+atomic_int __ispc_dispatch_max_isa = -1;
+
+// Used by the resolvers of --dispatch=ifunc only, see
+// __get_system_best_isa_ifunc.
+extern char **environ;
+
 // For function definitions, we need to use static keyword. This is because
 // because users can compile several translation units in multi-target mode and
 // link them together. Putting static let's us avoid the linker reporting
@@ -64,6 +77,35 @@ static int __get_system_isa() {
     return isa;
 }
 
+// Returns the ISA with the given name (see isa_names) or INVALID. It doesn't
+// call the C library, as it may run before the library is initialized.
+static int __parse_isa_name(const char *name) {
+    for (int isa = 0; isa < COUNT; ++isa) {
+        const char *a = name, *b = isa_names[isa];
+        while (*a != '\0' && *a == *b) {
+            ++a;
+            ++b;
+        }
+        if (*a == *b) {
+            return isa;
+        }
+    }
+    return INVALID;
+}
+
+// Limits the ISA that the system supports with max_isa, the ISA set with
+// ISPCSetDispatchMaxISA(), or, if it is negative, with the value of the
+// ISPC_DISPATCH_MAX_ISA environment variable. Unknown names are ignored.
+static int __limit_isa(int isa, int max_isa, const char *env_max_isa) {
+    if (max_isa < 0 && env_max_isa != NULL) {
+        max_isa = __parse_isa_name(env_max_isa);
+    }
+    if (max_isa >= 0 && max_isa < isa) {
+        isa = max_isa;
+    }
+    return isa;
+}
+
 int __get_system_best_isa() {
 
     int isa = atomic_load(&__system_best_isa);
@@ -72,5 +114,36 @@ int __get_system_best_isa() {
         atomic_store(&__system_best_isa, isa);
     }
 
-    return isa;
+    // It is called once per dispatch function, so the limit is applied to
+    // every dispatch function that is called first after it has been set.
+    return __limit_isa(isa, atomic_load(&__ispc_dispatch_max_isa), getenv("ISPC_DISPATCH_MAX_ISA"));
+}
+
+// Same as __get_system_best_isa for the resolvers of --dispatch=ifunc. They
+// run while the program is being loaded, possibly before the relocations of
+// the C library and of the shared __ispc_dispatch_max_isa are applied, so
+// only the environment is checked, by hand as getenv() can't be called there.
+// The environment may be not set up yet, in which case it is ignored.
+int __get_system_best_isa_ifunc() {
+    const char *env_max_isa = NULL;
+    const char *var = "ISPC_DISPATCH_MAX_ISA=";
+    for (char **env = environ; env != NULL && *env != NULL && env_max_isa == NULL; ++env) {
+        const char *a = *env, *b = var;
+        while (*b != '\0' && *a == *b) {
+            ++a;
+            ++b;
+        }
+        if (*b == '\0') {
+            env_max_isa = a;
+        }
+    }
+    return __limit_isa(__get_system_isa(), -1, env_max_isa);
 }
+
+// Sets the maximal ISA used by the dispatch functions that haven't been called
+// yet (see the generated header); a negative value removes the limit.
+void ISPCSetDispatchMaxISA(int32_t isa) { atomic_store(&__ispc_dispatch_max_isa, isa < 0 ? -1 : isa); }
+
+// Returns the most capable ISA that the dispatch functions called first from now
+// on may use.
+int32_t ISPCGetDispatchISA() { return __get_system_best_isa(); }
@@ -9,6 +9,7 @@
 */
 
 #include "args.h"
+#include "compile_cache.h"
 #include "ispc.h"
 #include "ispc_version.h"
 #include "module.h"
@@ -56,9 +57,14 @@ static ArgsParseResult usage() {
     printf("    [--addressing={32,64}]\t\tSelect 32- or 64-bit addressing. (Note that 32-bit addressing calculations "
            "are done by default, even on 64-bit target architectures.)\n");
     printf("    [--arch={%s}]\t\tSelect target architecture\n", g->target_registry->getSupportedArchs().c_str());
+    printf("    [--batch=<file>]\t\t\tRun the compile jobs listed in <file>, one command line per line\n");
 #ifndef ISPC_HOST_IS_WINDOWS
+    printf("    [--cache-dir=<dir>]\t\tReuse outputs of identical compilations cached in <dir>\n");
+    printf("    [--cache-max-size=<MB>]\t\tLimit the size of the compilation cache (default: 5120 MB)\n");
+    printf("    [--cache-stats]\t\t\tPrint statistics of the compilation cache and exit\n");
     printf("    [--colored-output]\t\t\tAlways use terminal colors in error/warning messages\n");
 #endif
+    printf("    [--compile-report=<file>]\t\tWrite per-phase compile time and memory statistics to <file> in JSON\n");
     printf("    [--cpu=<type>]\t\t\tAn alias for [--device=<type>] switch\n");
     printf("    [-D<foo>]\t\t\t\t#define given value when running preprocessor\n");
 #if defined(ISPC_MACOS_TARGET_ON) || defined(ISPC_IOS_TARGET_ON)
@@ -72,6 +78,10 @@ static ArgsParseResult usage() {
     snprintf(cpuHelp, sizeof(cpuHelp), "[--device=<type>]\t\t\tSelect target device\n<type>={%s}\n",
              Target::SupportedCPUs().c_str());
     PrintWithWordBreaks(cpuHelp, 16, TerminalWidth(), stdout);
+    printf("    [--dispatch=<option>]\t\tSelect how dispatch functions of multi-target compilation pick the target\n");
+    printf("        pointer\t\t\t\tCheck the system ISA on the first call and cache the choice (default)\n");
+    printf("        ifunc\t\t\t\tResolve once, when the program is loaded, using GNU indirect functions "
+           "(Linux, FreeBSD and Android)\n");
     printf("    [--dllexport]\t\t\tMake non-static functions DLL exported.  Windows target only\n");
     printf("    [-dM]\t\t\t\tPrint macro definitions for the preprocessor result\n");
     printf("    [--dwarf-version={2,3,4,5}]\t\tGenerate source-level debug information with given DWARF version "
@@ -104,6 +114,8 @@ static ArgsParseResult usage() {
         "    [--include-float16-conversions]\tAdd float16 conversion functions permanently to the compiled module\n");
     printf("    [--ignore-preprocessor-errors]\tSuppress errors from the preprocessor\n");
     printf("    [--instrument]\t\t\tEmit instrumentation to gather performance data\n");
+    printf("    [--interface-fingerprint=<file>]\tWrite fingerprints of the exported functions and types to <file>\n");
+    printf("    [--jobs=<N>]\t\t\tUse <N> threads for code generation (<N> worker processes with --batch)\n");
     printf("    [--math-lib=<option>]\t\tSelect math library\n");
     printf("        default\t\t\t\tUse ispc's built-in math functions\n");
     printf("        fast\t\t\t\tUse high-performance but lower-accuracy math functions\n");
@@ -120,6 +132,8 @@ static ArgsParseResult usage() {
     printf("    [-MF <filename>]\t\t\tWhen used with `-M', specifies a file to write the dependencies to\n");
     printf("    [-MT <filename>]\t\t\tWhen used with `-M', changes the target of the rule emitted by dependency "
            "generation\n");
+    printf("    [--scan-deps]\t\t\tOnly run the preprocessor to write the dependencies given by `-M' or `-MMM'; "
+           "accepts several source files\n");
     printf("    [--nanobind-wrapper=<filename>]\tWrite a nanobind wrapper to given file\n");
     printf("    [--no-omit-frame-pointer]\t\tDisable frame pointer omission. It may be useful for profiling\n");
     printf("    [--nostdlib]\t\t\tDon't make the ispc standard library available\n");
@@ -168,6 +182,7 @@ static ArgsParseResult usage() {
     snprintf(targetHelp, sizeof(targetHelp), "[--target-os=<os>]\t\t\tSelect target OS.  <os>={%s}",
              g->target_registry->getSupportedOSes().c_str());
     PrintWithWordBreaks(targetHelp, 24, TerminalWidth(), stdout);
+    printf("    [--template-cache-dir=<dir>]\tShare optimized template instantiations between compilations in <dir>\n");
     printf("    [--vectorcall/--no-vectorcall]\tEnable/disable vectorcall calling convention on Windows (x64 only). "
            "Disabled by default\n");
     printf("    [--internal-export-functions/--no-internal-export-functions]\n");
@@ -196,19 +211,30 @@ static ArgsParseResult usage() {
 static ArgsParseResult linkUsage() {
     lPrintVersion();
     printf("\nusage: ispc link\n");
-    printf("\nLink several IR or SPIR-V files to selected output format: LLVM BC (default), LLVM text or SPIR-V\n");
+    printf("\nLink several IR or SPIR-V files to selected output format: LLVM BC (default), LLVM text, SPIR-V,\n"
+           "object file or assembly\n");
+    printf("    [--emit-asm]\t\t\tEmit assembly code for the target given by --target\n");
     printf("    [--emit-llvm]\t\t\tEmit LLVM bitcode file as output\n");
     printf("    [--emit-llvm-text]\t\t\tEmit LLVM bitcode file as output in textual form\n");
+    printf("    [--emit-obj]\t\t\tGenerate object file for the target given by --target\n");
 #ifdef ISPC_XE_ENABLED
     printf("    [--emit-spirv]\t\t\tEmit SPIR-V file as output\n");
 #endif
     printf("    [-o <name>/--outfile=<name>]\tOutput filename (may be \"-\" for standard output)\n");
+    printf("    [-O0/-O(1/2/3)]\t\t\tOptimize the linked module for the target given by --target\n");
+    printf("        \t\t\t\tFunctions with mangled names are not visible outside of the linked files\n");
+    printf("    [--pic]\t\t\t\tGenerate position-independent code.  Ignored for Windows target\n");
+    printf("    [--PIC]\t\t\t\tGenerate position-independent code avoiding any limit on the size of GOT\n");
+    printf("    [--target=<t>]\t\t\tTarget of the linked files, required with -O(1/2/3), --emit-obj and "
+           "--emit-asm\n");
     printf("    <files to link or \"-\" for stdin>\n");
     printf("\nExamples:\n");
     printf("    Link two SPIR-V files to LLVM BC output:\n");
     printf("        ispc link test_a.spv test_b.spv --emit-llvm -o test.bc\n");
     printf("    Link LLVM bitcode files to SPIR-V output:\n");
     printf("        ispc link test_a.bc test_b.bc --emit-spirv -o test.spv\n");
+    printf("    Link and optimize LLVM bitcode files to an object file:\n");
+    printf("        ispc link test_a.bc test_b.bc --target=avx2-i32x8 -O2 --emit-obj -o test.o\n");
     return ArgsParseResult::help_requested;
 }
 
@@ -237,11 +263,13 @@ static ArgsParseResult devUsage() {
     printf("        disable-all-on-optimizations\t\tDisable optimizations that take advantage of \"all on\" mask\n");
     printf("        disable-blended-masked-stores\t\tScalarize masked stores on SSE (vs. using vblendps)\n");
     printf("        disable-blending-removal\t\tDisable eliminating blend at same scope\n");
-    printf("        disable-coalescing\t\t\tDisable gather coalescing\n");
+    printf("        disable-coalescing\t\t\tDisable gather and scatter coalescing\n");
     printf("        disable-coherent-control-flow\t\tDisable coherent control flow optimizations\n");
     printf("        disable-gather-scatter-flattening\tDisable flattening when all lanes are on\n");
     printf("        disable-gather-scatter-optimizations\tDisable improvements to gather/scatter\n");
+    printf("        disable-gather-scatter-versioning\tDisable run time checks for contiguous gather/scatter\n");
     printf("        disable-handle-pseudo-memory-ops\tLeave __pseudo_* calls for gather/scatter/etc. in final IR\n");
+    printf("        disable-uniform-arg-specialization\tDisable cloning functions for uniform arguments\n");
     printf("        disable-uniform-control-flow\t\tDisable uniform control flow optimizations\n");
     printf("        disable-uniform-memory-optimizations\tDisable uniform-based coherent memory access\n");
 #ifdef ISPC_XE_ENABLED
@@ -417,6 +445,8 @@ void ispc::GetAllArgs(int Argc, char *Argv[], std::vector<char *> &argv) {
     }
 }
 
+void ispc::GetArgsFromString(const char *string, std::vector<char *> &argv) { lAddArgsFromString(string, argv); }
+
 void ispc::FreeArgv(std::vector<char *> &argv) {
     // argv vector consists of pointers to arguments as C strings alloced on
     // heap and collected form three source:  environment variable ISPC_ARGS,
@@ -601,6 +631,33 @@ ArgsParseResult ispc::ParseCommandLineArgs(int argc, char *argv[], std::string &
                 output.type = Module::Bitcode;
             } else if (!strcmp(argv[i], "--emit-llvm-text")) {
                 output.type = Module::BitcodeText;
+            } else if (!strcmp(argv[i], "--emit-obj")) {
+                output.type = Module::Object;
+            } else if (!strcmp(argv[i], "--emit-asm")) {
+                output.type = Module::Asm;
+            } else if (!strncmp(argv[i], "--target=", 9)) {
+                auto result = ParseISPCTargets(argv[i] + 9);
+                targets = result.first;
+                if (!result.second.empty()) {
+                    errorHandler.AddError("Incorrect targets: %s.  Choices are: %s.", result.second.c_str(),
+                                          g->target_registry->getSupportedTargets().c_str());
+                }
+            } else if (!strcmp(argv[i], "-O0")) {
+                g->opt.level = 0;
+                g->codegenOptLevel = Globals::CodegenOptLevel::None;
+                g->optimizeLinkedModule = false;
+            } else if (!strcmp(argv[i], "-O1")) {
+                g->opt.level = 1;
+                g->codegenOptLevel = Globals::CodegenOptLevel::Default;
+                g->optimizeLinkedModule = true;
+            } else if (!strcmp(argv[i], "-O") || !strcmp(argv[i], "-O2") || !strcmp(argv[i], "-O3")) {
+                g->opt.level = 2;
+                g->codegenOptLevel = Globals::CodegenOptLevel::Aggressive;
+                g->optimizeLinkedModule = true;
+            } else if (!strcmp(argv[i], "--pic")) {
+                output.flags.setPICLevel(PICLevel::SmallPIC);
+            } else if (!strcmp(argv[i], "--PIC")) {
+                output.flags.setPICLevel(PICLevel::BigPIC);
             } else if (argv[i][0] == '-') {
                 errorHandler.AddError("Unknown option \"%s\".", argv[i]);
             } else {
@@ -618,6 +675,13 @@ ArgsParseResult ispc::ParseCommandLineArgs(int argc, char *argv[], std::string &
             return ArgsParseResult::failure;
         }
 
+        bool needsTarget = g->optimizeLinkedModule || output.type == Module::Object || output.type == Module::Asm;
+        if (needsTarget && targets.size() != 1) {
+            Error(SourcePos(), "A single --target is required to optimize the linked module or to emit an object "
+                               "file or assembly.");
+            return ArgsParseResult::failure;
+        }
+
         if (output.out.empty()) {
             Warning(SourcePos(), "No output file name specified. "
                                  "The inputs will be linked and warnings/errors will "
@@ -627,6 +691,14 @@ ArgsParseResult ispc::ParseCommandLineArgs(int argc, char *argv[], std::string &
         return ArgsParseResult::success;
     }
 
+    // Everything but the cache options affects the compilation result.
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--cache-", 8)) {
+            g->cacheKeyArgs.push_back(argv[i]);
+        }
+    }
+    bool printCacheStats = false;
+
     for (int i = 1; i < argc; ++i) {
         if (!strcmp(argv[i], "--help")) {
             return usage();
@@ -820,6 +892,15 @@ ArgsParseResult ispc::ParseCommandLineArgs(int argc, char *argv[], std::string &
             g->generateInternalExportFunctions = false;
         } else if (!strcmp(argv[i], "--internal-export-functions")) {
             g->generateInternalExportFunctions = true;
+        } else if (!strncmp(argv[i], "--dispatch=", 11)) {
+            const char *mode = argv[i] + 11;
+            if (!strcmp(mode, "pointer")) {
+                g->dispatchMode = Globals::DispatchMode::Pointer;
+            } else if (!strcmp(mode, "ifunc")) {
+                g->dispatchMode = Globals::DispatchMode::IFunc;
+            } else {
+                errorHandler.AddError("Unknown --dispatch= option \"%s\".", mode);
+            }
         } else if (!strncmp(argv[i], "--math-lib=", 11)) {
             const char *lib = argv[i] + 11;
             if (!strcmp(lib, "default")) {
@@ -877,6 +958,10 @@ ArgsParseResult ispc::ParseCommandLineArgs(int argc, char *argv[], std::string &
                 g->opt.disableUniformControlFlow = true;
             } else if (!strcmp(opt, "disable-gather-scatter-optimizations")) {
                 g->opt.disableGatherScatterOptimizations = true;
+            } else if (!strcmp(opt, "disable-gather-scatter-versioning")) {
+                g->opt.disableGatherScatterVersioning = true;
+            } else if (!strcmp(opt, "disable-uniform-arg-specialization")) {
+                g->opt.disableUniformArgSpecialization = true;
             } else if (!strcmp(opt, "disable-blending-removal")) {
                 g->opt.disableMaskedStoreToStore = true;
             } else if (!strcmp(opt, "disable-gather-scatter-flattening")) {
@@ -915,6 +1000,34 @@ ArgsParseResult ispc::ParseCommandLineArgs(int argc, char *argv[], std::string &
             wrapSignedInt = BooleanOptValue::enabled;
         } else if (!strcmp(argv[i], "--no-wrap-signed-int")) {
             wrapSignedInt = BooleanOptValue::disabled;
+        } else if (!strncmp(argv[i], "--cache-dir=", 12)) {
+            g->cacheDir = argv[i] + 12;
+        } else if (!strncmp(argv[i], "--cache-max-size=", 17)) {
+            long long size = atoll(argv[i] + 17);
+            if (size > 0) {
+                g->cacheMaxSize = static_cast<uint64_t>(size) * 1024 * 1024;
+            } else {
+                errorHandler.AddError("Invalid value for --cache-max-size: \"%s\" -- "
+                                      "value must be a positive number of megabytes.",
+                                      argv[i] + 17);
+            }
+        } else if (!strncmp(argv[i], "--compile-report=", 17)) {
+            g->compileReportFile = argv[i] + 17;
+        } else if (!strncmp(argv[i], "--template-cache-dir=", 21)) {
+            g->templateCacheDir = argv[i] + 21;
+        } else if (!strncmp(argv[i], "--batch=", 8)) {
+            g->batchManifest = argv[i] + 8;
+        } else if (!strcmp(argv[i], "--cache-stats")) {
+            printCacheStats = true;
+        } else if (!strncmp(argv[i], "--jobs=", 7)) {
+            int jobs = atoi(argv[i] + 7);
+            if (jobs > 0) {
+                g->numJobs = jobs;
+            } else {
+                errorHandler.AddError("Invalid value for --jobs: \"%s\" -- "
+                                      "value must be a positive number.",
+                                      argv[i] + 7);
+            }
         } else if (!strncmp(argv[i], "--error-limit=", 14)) {
             int errLimit = atoi(argv[i] + 14);
             if (errLimit >= 0) {
@@ -959,6 +1072,8 @@ ArgsParseResult ispc::ParseCommandLineArgs(int argc, char *argv[], std::string &
             }
         } else if (!strncmp(argv[i], "--header-outfile=", 17)) {
             output.header = argv[i] + strlen("--header-outfile=");
+        } else if (!strncmp(argv[i], "--interface-fingerprint=", 24)) {
+            output.fingerprint = argv[i] + 24;
         } else if (!strncmp(argv[i], "--nanobind-wrapper=", 19)) {
             output.nbWrap = argv[i] + strlen("--nanobind-wrapper=");
         } else if (!strcmp(argv[i], "-O0")) {
@@ -1024,6 +1139,8 @@ ArgsParseResult ispc::ParseCommandLineArgs(int argc, char *argv[], std::string &
             } else {
                 errorHandler.AddError("No output file name specified after -MF option.");
             }
+        } else if (!strcmp(argv[i], "--scan-deps")) {
+            g->scanDeps = true;
         } else if (!strcmp(argv[i], "-MT")) {
             if (++i != argc) {
                 output.depsTarget = argv[i];
@@ -1075,22 +1192,38 @@ ArgsParseResult ispc::ParseCommandLineArgs(int argc, char *argv[], std::string &
         } else if (argv[i][0] == '-') {
             errorHandler.AddError("Unknown option \"%s\".", argv[i]);
         } else {
-            if (!file.empty()) {
-                errorHandler.AddError("Multiple input files specified on command "
-                                      "line: \"%s\" and \"%s\".",
-                                      file.c_str(), argv[i]);
-            } else {
+            if (file.empty()) {
                 file = argv[i];
             }
+            g->scanDepsFiles.push_back(argv[i]);
         }
     }
 
+    // Only the dependency scan takes several input files.
+    if (!g->scanDeps) {
+        for (size_t j = 1; j < g->scanDepsFiles.size(); ++j) {
+            errorHandler.AddError("Multiple input files specified on command "
+                                  "line: \"%s\" and \"%s\".",
+                                  file.c_str(), g->scanDepsFiles[j].c_str());
+        }
+        g->scanDepsFiles.clear();
+    }
+
     // Emit accumulted errors and warnings, if any.
     // All the rest of errors and warnigns will be processed in regullar way.
     if (auto result = errorHandler.Emit(); result != ArgsParseResult::success) {
         return result;
     }
 
+    if (printCacheStats) {
+        if (g->cacheDir.empty()) {
+            Error(SourcePos(), "The --cache-stats option requires --cache-dir=<dir>.");
+            return ArgsParseResult::failure;
+        }
+        CompilationCache::PrintStats(g->cacheDir);
+        return ArgsParseResult::help_requested;
+    }
+
     if (g->genStdlib) {
         std::string stdlib = "stdlib/stdlib.ispc";
         std::string generic = "builtins/generic.ispc";
@@ -1197,6 +1330,11 @@ ArgsParseResult ispc::ParseCommandLineArgs(int argc, char *argv[], std::string &
         output.flags.setFlatDeps(false);
     }
 
+    if (g->scanDeps && !output.flags.isFlatDeps() && !output.flags.isMakeRuleDeps()) {
+        Error(SourcePos(), "--scan-deps requires -M or -MMM.");
+        return ArgsParseResult::failure;
+    }
+
     if (g->onlyCPP && output.out.empty()) {
         output.out = "-"; // Assume stdout by default (-E mode)
     }
@@ -1205,6 +1343,13 @@ ArgsParseResult ispc::ParseCommandLineArgs(int argc, char *argv[], std::string &
         Warning(SourcePos(), "--pic|--PIC switches for Windows target will be ignored.");
     }
 
+    if (g->dispatchMode == Globals::DispatchMode::IFunc && g->target_os != TargetOS::linux &&
+        g->target_os != TargetOS::custom_linux && g->target_os != TargetOS::freebsd &&
+        g->target_os != TargetOS::android) {
+        Warning(SourcePos(), "--dispatch=ifunc is not supported for the target OS, --dispatch=pointer will be used.");
+        g->dispatchMode = Globals::DispatchMode::Pointer;
+    }
+
     if (g->target_os != TargetOS::windows && g->dllExport) {
         Warning(SourcePos(), "--dllexport switch will be ignored, as the target OS is not Windows.");
     }
@@ -1316,7 +1461,7 @@ bool ispc::ValidateInput(const std::string &filename, bool allowStdin) {
 
 void ispc::ValidateOutput(const Module::Output &output) {
     if (output.out.empty() && output.header.empty() && (output.deps.empty() && !output.flags.isDepsToStdout()) &&
-        output.hostStub.empty() && output.devStub.empty() && output.nbWrap.empty()) {
+        output.hostStub.empty() && output.devStub.empty() && output.nbWrap.empty() && output.fingerprint.empty()) {
         Warning(SourcePos(), "No output file or header file name specified. "
                              "Program will be compiled and warnings/errors will "
                              "be issued, but no output will be generated.");
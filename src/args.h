@@ -28,6 +28,12 @@ enum class ArgsParseResult : int { success = 0, failure = 1, help_requested = 2
  */
 void GetAllArgs(int Argc, char *Argv[], std::vector<char *> &argv);
 
+/** Break a string into individual arguments the same way as the ISPC_ARGS
+ *  environment variable, including @<filename> expansion. The arguments have
+ *  to be released with FreeArgv().
+ */
+void GetArgsFromString(const char *string, std::vector<char *> &argv);
+
 /** Free all dynamically allocated argument strings */
 void FreeArgv(std::vector<char *> &argv);
 
@@ -0,0 +1,184 @@
+/*
+  Copyright (c) 2026, Intel Corporation
+
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+/** @file batch.cpp
+    @brief Implementation of the batch compilation mode.
+*/
+
+#include "batch.h"
+#include "args.h"
+#include "binary_type.h"
+#include "bitcode_lib.h"
+#include "ispc.h"
+#include "ispc/ispc.h"
+#include "util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <stdio.h>
+#include <vector>
+
+#include <llvm/Support/FileSystem.h>
+
+#ifndef ISPC_HOST_IS_WINDOWS
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace ispc;
+
+struct BatchJob {
+    int line;
+    std::string args;
+};
+
+static bool lReadManifest(const std::string &manifest, std::vector<BatchJob> &jobs) {
+    std::ifstream in(manifest);
+    if (!in) {
+        Error(SourcePos(), "Can't open batch manifest \"%s\".", manifest.c_str());
+        return false;
+    }
+    std::string text;
+    for (int line = 1; std::getline(in, text); ++line) {
+        size_t start = text.find_first_not_of(" \t\r");
+        if (start == std::string::npos || text[start] == '#') {
+            continue;
+        }
+        jobs.push_back({line, text.substr(start)});
+    }
+    return true;
+}
+
+/** Runs a single job with the default options. The distribution specific
+    paths are set up from the executable path as main() does for a regular
+    invocation. The LLVM context and the cache of parsed bitcode libraries
+    are handed over from the batch globals to the job and back, so they
+    survive from one job to the next. */
+static int lRunJob(const BatchJob &job, const std::string &executablePath) {
+    std::vector<char *> argv;
+    GetArgsFromString(job.args.c_str(), argv);
+    // The jobs are compiled as separate ispc invocations would be.
+    if (const char *env = getenv("ISPC_ARGS")) {
+        GetArgsFromString(env, argv);
+    }
+    for (const char *arg : argv) {
+        if (!strncmp(arg, "--batch=", 8)) {
+            Error(SourcePos(), "The --batch option can't be used in a batch job.");
+            FreeArgv(argv);
+            return 1;
+        }
+    }
+
+    Globals *batchGlobals = g;
+    g = new Globals;
+    initializeBinaryType(executablePath.c_str());
+    std::swap(g->ctx, batchGlobals->ctx);
+    std::swap(g->bitcodeLibCache, batchGlobals->bitcodeLibCache);
+    if (g->bitcodeLibCache == nullptr) {
+        g->bitcodeLibCache = new BitcodeLibCache();
+    }
+
+    int ret = CompileFromCArgs(static_cast<int>(argv.size()), argv.data());
+
+    std::swap(g->ctx, batchGlobals->ctx);
+    std::swap(g->bitcodeLibCache, batchGlobals->bitcodeLibCache);
+    delete g;
+    g = batchGlobals;
+
+    FreeArgv(argv);
+    return ret;
+}
+
+static void lRunJobs(const std::vector<BatchJob> &jobs, const std::string &executablePath,
+                     std::vector<int> &results) {
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        results[i] = lRunJob(jobs[i], executablePath);
+    }
+}
+
+#ifndef ISPC_HOST_IS_WINDOWS
+/** Forks numWorkers processes that take jobs from a shared counter until all
+    of them are done. Nothing is initialized before forking: every worker
+    parses the bitcode libraries its first jobs need and keeps them, together
+    with its LLVM context, for the jobs it runs after them. Returns false if
+    no worker could be started. */
+static bool lRunJobsInWorkers(const std::vector<BatchJob> &jobs, int numWorkers, const std::string &executablePath,
+                              std::vector<int> &results) {
+    size_t size = sizeof(std::atomic<size_t>) + jobs.size() * sizeof(int);
+    void *shared = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        return false;
+    }
+    std::atomic<size_t> *nextJob = new (shared) std::atomic<size_t>(0);
+    int *sharedResults = reinterpret_cast<int *>(nextJob + 1);
+    // Jobs of a crashed worker are reported as failed.
+    std::fill(sharedResults, sharedResults + jobs.size(), 1);
+
+    // Don't let the workers inherit buffered output of the parent.
+    fflush(nullptr);
+
+    std::vector<pid_t> workers;
+    for (int i = 0; i < numWorkers; ++i) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            for (size_t job = nextJob->fetch_add(1); job < jobs.size(); job = nextJob->fetch_add(1)) {
+                sharedResults[job] = lRunJob(jobs[job], executablePath);
+            }
+            fflush(nullptr);
+            _exit(0);
+        }
+        if (pid > 0) {
+            workers.push_back(pid);
+        }
+    }
+
+    for (pid_t pid : workers) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+    }
+
+    bool started = !workers.empty();
+    if (started) {
+        std::copy(sharedResults, sharedResults + jobs.size(), results.begin());
+    }
+    munmap(shared, size);
+    return started;
+}
+#endif // !ISPC_HOST_IS_WINDOWS
+
+int ispc::CompileBatch(const std::string &manifest, int numWorkers) {
+    std::vector<BatchJob> jobs;
+    if (!lReadManifest(manifest, jobs)) {
+        return 1;
+    }
+
+    // Every job sets up the stdlib include and share/ispc paths from it.
+    std::string executablePath = llvm::sys::fs::getMainExecutable(nullptr, (void *)(intptr_t)CompileBatch);
+    std::vector<int> results(jobs.size(), 1);
+    numWorkers = std::min(numWorkers, static_cast<int>(jobs.size()));
+#ifndef ISPC_HOST_IS_WINDOWS
+    if (numWorkers <= 1 || !lRunJobsInWorkers(jobs, numWorkers, executablePath, results)) {
+        lRunJobs(jobs, executablePath, results);
+    }
+#else
+    // There is no fork() on Windows, all jobs run in this process.
+    lRunJobs(jobs, executablePath, results);
+#endif
+
+    int failed = 0;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (results[i] != 0) {
+            Error(SourcePos(), "Batch job at %s:%d failed.", manifest.c_str(), jobs[i].line);
+            ++failed;
+        }
+    }
+    return failed;
+}
@@ -0,0 +1,30 @@
+/*
+  Copyright (c) 2026, Intel Corporation
+
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+/** @file batch.h
+    @brief Compilation of many source files in one process (see --batch).
+*/
+
+#pragma once
+
+#include <string>
+
+namespace ispc {
+
+/** Runs the compile jobs listed in the manifest file. Every non-empty line of
+    the manifest that doesn't start with '#' is a job: the command-line
+    arguments of a regular ispc invocation (source file, targets, flags and
+    output files). Jobs start with the default options, but share the LLVM
+    context and the parsed builtins and stdlib bitcode with the jobs executed
+    before them in the same process.
+
+    On POSIX hosts the jobs are distributed over numWorkers worker processes
+    forked from the current one. Every worker builds that state for its first
+    jobs and reuses it for the following ones. Returns the number of failed
+    jobs. */
+int CompileBatch(const std::string &manifest, int numWorkers);
+
+} // namespace ispc
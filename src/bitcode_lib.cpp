@@ -18,8 +18,12 @@
 
 #include "llvm/Support/MemoryBuffer.h"
 #include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/IR/GVMaterializer.h>
+#include <llvm/IR/TypeFinder.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Path.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/ValueMapper.h>
 
 using namespace ispc;
 
@@ -127,41 +131,158 @@ bool BitcodeLib::fileExists() const {
 }
 
 llvm::Module *BitcodeLib::getLLVMModule() const {
-    switch (m_storage) {
-    case BitcodeLibStorage::FileSystem: {
+    if (g->bitcodeLibCache) {
+        return g->bitcodeLibCache->getModule(this);
+    }
+    return parseLLVMModule();
+}
+
+llvm::MemoryBufferRef BitcodeLib::getFileContent() const {
+    std::lock_guard<std::mutex> lock(m_mappingMutex);
+    if (!m_mapping) {
         llvm::SmallString<128> filePath(g->shareDirPath);
         llvm::sys::path::append(filePath, m_filename);
-        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> bufferOrErr = llvm::MemoryBuffer::getFile(filePath.str());
+        // The bitcode reader doesn't need the buffer to be null terminated,
+        // which lets MemoryBuffer map the file instead of reading it.
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> bufferOrErr =
+            llvm::MemoryBuffer::getFile(filePath.str(), /*IsText*/ false, /*RequiresNullTerminator*/ false);
         if (std::error_code EC = bufferOrErr.getError()) {
             Error(SourcePos(), "Error reading bc_filename %s\n%s\n", m_filename.c_str(), EC.message().c_str());
             exit(1);
         }
-        llvm::Expected<std::unique_ptr<llvm::Module>> ModuleOrErr =
-            llvm::parseBitcodeFile(bufferOrErr->get()->getMemBufferRef(), *g->ctx);
-        if (!ModuleOrErr) {
-            Error(SourcePos(), "Error parsing bitcode from filename %s\n", m_filename.c_str());
-            exit(1);
-        } else {
-            llvm::Module *M = ModuleOrErr.get().release();
-            return M;
-        }
-        return nullptr;
+        m_mapping = std::move(bufferOrErr.get());
+    }
+    return m_mapping->getMemBufferRef();
+}
+
+llvm::Module *BitcodeLib::parseLLVMModule() const {
+    std::unique_ptr<llvm::MemoryBuffer> buffer;
+    switch (m_storage) {
+    case BitcodeLibStorage::FileSystem: {
+        // The module reads the mapping in place, without copying it.
+        buffer = llvm::MemoryBuffer::getMemBuffer(getFileContent(), /*RequiresNullTerminator*/ false);
+        break;
     }
     case BitcodeLibStorage::Embedded: {
         llvm::StringRef sb = llvm::StringRef((const char *)m_lib, m_size);
-        llvm::MemoryBufferRef bcBuf = llvm::MemoryBuffer::getMemBuffer(sb)->getMemBufferRef();
-        llvm::Expected<std::unique_ptr<llvm::Module>> ModuleOrErr = llvm::parseBitcodeFile(bcBuf, *g->ctx);
-        if (!ModuleOrErr) {
-            Error(SourcePos(), "Error parsing stdlib bitcode: %s", toString(ModuleOrErr.takeError()).c_str());
-            exit(1);
-        } else {
-            llvm::Module *M = ModuleOrErr.get().release();
-            return M;
-        }
-        return nullptr;
+        buffer = llvm::MemoryBuffer::getMemBuffer(sb, "", /*RequiresNullTerminator*/ false);
+        break;
     }
     default:
         Error(SourcePos(), "Error loading bitcode library\n");
         exit(1);
     }
+
+    // Only the global values' declarations are read here. Function bodies
+    // are read when they are materialized, i.e. when the linker needs them
+    // (see lAddBitcodeToModule), so the bodies of unused library functions
+    // are never parsed.
+    llvm::Expected<std::unique_ptr<llvm::Module>> ModuleOrErr =
+        llvm::getOwningLazyBitcodeModule(std::move(buffer), *g->ctx);
+    if (!ModuleOrErr) {
+        Error(SourcePos(), "Error parsing bitcode library %s: %s", m_filename.c_str(),
+              toString(ModuleOrErr.takeError()).c_str());
+        exit(1);
+    }
+    return ModuleOrErr.get().release();
+}
+
+// Materializes the functions of a module created by BitcodeLibCache by
+// copying their bodies from the cached module.
+class CachedLibMaterializer : public llvm::GVMaterializer {
+  public:
+    CachedLibMaterializer(const llvm::Module *source, llvm::Module *module,
+                          std::unique_ptr<llvm::ValueToValueMapTy> vmap)
+        : m_source(source), m_module(module), m_vmap(std::move(vmap)) {}
+
+    void addFunction(llvm::Function *F, const llvm::Function *source) { m_functions[F] = source; }
+
+    llvm::Error materialize(llvm::GlobalValue *GV) override {
+        llvm::Function *F = llvm::dyn_cast<llvm::Function>(GV);
+        if (F == nullptr || !F->isMaterializable()) {
+            return llvm::Error::success();
+        }
+        auto it = m_functions.find(F);
+        Assert(it != m_functions.end());
+        F->setIsMaterializable(false);
+        llvm::Function::arg_iterator arg = F->arg_begin();
+        for (const llvm::Argument &sourceArg : it->second->args()) {
+            arg->setName(sourceArg.getName());
+            (*m_vmap)[&sourceArg] = &*arg++;
+        }
+        llvm::SmallVector<llvm::ReturnInst *, 8> returns;
+        llvm::CloneFunctionInto(F, it->second, *m_vmap, llvm::CloneFunctionChangeType::ClonedModule, returns);
+        return llvm::Error::success();
+    }
+
+    llvm::Error materializeModule() override {
+        for (llvm::Function &F : *m_module) {
+            if (llvm::Error err = materialize(&F)) {
+                return err;
+            }
+        }
+        return llvm::Error::success();
+    }
+
+    llvm::Error materializeMetadata() override { return llvm::Error::success(); }
+
+    void setStripDebugInfo() override {}
+
+    std::vector<llvm::StructType *> getIdentifiedStructTypes() const override {
+        // Bodies that are not copied yet may use types that are not visible
+        // in the module, so look for them in the cached one.
+        llvm::TypeFinder types;
+        types.run(*m_source, true);
+        return std::vector<llvm::StructType *>(types.begin(), types.end());
+    }
+
+  private:
+    const llvm::Module *m_source;
+    llvm::Module *m_module;
+    std::unique_ptr<llvm::ValueToValueMapTy> m_vmap;
+    std::unordered_map<llvm::Function *, const llvm::Function *> m_functions;
+};
+
+llvm::Module *BitcodeLibCache::getModule(const BitcodeLib *lib) {
+    std::unique_ptr<llvm::Module> &cached = m_modules[lib];
+    if (!cached) {
+        cached.reset(lib->parseLLVMModule());
+        if (llvm::Error err = cached->materializeAll()) {
+            Error(SourcePos(), "Error loading bitcode library %s: %s", lib->getFilename().c_str(),
+                  llvm::toString(std::move(err)).c_str());
+            exit(1);
+        }
+    }
+
+    // Copy everything but function bodies.
+    auto vmap = std::make_unique<llvm::ValueToValueMapTy>();
+    std::unique_ptr<llvm::Module> module =
+        llvm::CloneModule(*cached, *vmap, [](const llvm::GlobalValue *GV) { return !llvm::isa<llvm::Function>(GV); });
+
+    // CloneModule() turns the definitions that are not copied to external
+    // declarations. Mark them as materializable definitions instead and
+    // restore their original properties, like the bitcode reader does for
+    // lazily loaded functions.
+    std::vector<std::pair<llvm::Function *, const llvm::Function *>> functions;
+    for (const llvm::Function &source : *cached) {
+        if (source.isDeclaration()) {
+            continue;
+        }
+        llvm::Function *F = llvm::cast<llvm::Function>((*vmap)[&source]);
+        F->setIsMaterializable(true);
+        F->setLinkage(source.getLinkage());
+        if (const llvm::Comdat *SC = source.getComdat()) {
+            llvm::Comdat *DC = module->getOrInsertComdat(SC->getName());
+            DC->setSelectionKind(SC->getSelectionKind());
+            F->setComdat(DC);
+        }
+        functions.push_back({F, &source});
+    }
+
+    auto materializer = std::make_unique<CachedLibMaterializer>(cached.get(), module.get(), std::move(vmap));
+    for (const auto &[F, source] : functions) {
+        materializer->addFunction(F, source);
+    }
+    module->setMaterializer(materializer.release());
+    return module.release();
 }
@@ -12,7 +12,12 @@
 
 #include "target_enums.h"
 
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
 #include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
 
 namespace ispc {
 
@@ -37,6 +42,15 @@ class BitcodeLib {
 
     const std::string m_filename;
 
+    // Memory mapping of the library file (for FileSystem storage). It is
+    // created on first use and then shared by all the modules read from the
+    // library, e.g. for every target of a multi-target compilation.
+    mutable std::unique_ptr<llvm::MemoryBuffer> m_mapping;
+    mutable std::mutex m_mappingMutex;
+
+    // Returns the content of the library file, mapping it if needed.
+    llvm::MemoryBufferRef getFileContent() const;
+
   public:
     // Every constructor is presented in two types: one for embedded bitcode
     // library and one for file system bitcode.
@@ -62,7 +76,28 @@ class BitcodeLib {
     ISPCTarget getISPCTarget() const;
     const std::string &getFilename() const;
     bool fileExists() const;
+    // Returns a lazily loaded module: function bodies are read from the
+    // bitcode on materialization. If g->bitcodeLibCache is set, the module is
+    // a lazy copy of the cached one instead.
     llvm::Module *getLLVMModule() const;
+    // Reads the module from the bitcode, bypassing g->bitcodeLibCache.
+    llvm::Module *parseLLVMModule() const;
+};
+
+// Keeps fully parsed bitcode libraries to avoid deserializing them for every
+// compilation when many modules are compiled within one LLVMContext (e.g. by
+// the JIT). The modules returned by getModule() are copies of the cached
+// ones. Only declarations are copied eagerly; function bodies are copied
+// when they are materialized, so linking with such a module costs about the
+// same as linking with a lazily loaded one.
+class BitcodeLibCache {
+  public:
+    // Returns a new module with the content of the library. The caller owns
+    // the module.
+    llvm::Module *getModule(const BitcodeLib *lib);
+
+  private:
+    std::unordered_map<const BitcodeLib *, std::unique_ptr<llvm::Module>> m_modules;
 };
 
 } // namespace ispc
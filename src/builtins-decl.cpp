@@ -96,6 +96,7 @@ DECL_BUILTIN_NAME(__gather_factored_base_offsets64_i32);
 DECL_BUILTIN_NAME(__gather_factored_base_offsets64_i64);
 DECL_BUILTIN_NAME(__gather_factored_base_offsets64_i8);
 DECL_BUILTIN_NAME(__get_system_best_isa);
+DECL_BUILTIN_NAME(__get_system_best_isa_ifunc);
 DECL_BUILTIN_NAME(__is_compile_time_constant_mask);
 DECL_BUILTIN_NAME(__is_compile_time_constant_uniform_int32);
 DECL_BUILTIN_NAME(__is_compile_time_constant_varying_int32);
@@ -110,10 +111,13 @@ DECL_BUILTIN_NAME(__ispc_amx_tile_load);
 DECL_BUILTIN_NAME(__ispc_amx_tile_load_t1);
 DECL_BUILTIN_NAME(__ispc_amx_tile_store);
 DECL_BUILTIN_NAME(__ispc_amx_tile_zero);
+DECL_BUILTIN_NAME(__ispc_dispatch_max_isa);
 DECL_BUILTIN_NAME(ISPCAlloc);
 DECL_BUILTIN_NAME(ISPCLaunch);
 DECL_BUILTIN_NAME(ISPCSync);
 DECL_BUILTIN_NAME(ISPCInstrument);
+DECL_BUILTIN_NAME(ISPCGetDispatchISA);
+DECL_BUILTIN_NAME(ISPCSetDispatchMaxISA);
 DECL_BUILTIN_NAME(__masked_load_blend_double);
 DECL_BUILTIN_NAME(__masked_load_blend_float);
 DECL_BUILTIN_NAME(__masked_load_blend_half);
@@ -148,6 +148,7 @@ extern const char *const __gather_factored_base_offsets64_i32;
 extern const char *const __gather_factored_base_offsets64_i64;
 extern const char *const __gather_factored_base_offsets64_i8;
 extern const char *const __get_system_best_isa;
+extern const char *const __get_system_best_isa_ifunc;
 extern const char *const __is_compile_time_constant_mask;
 extern const char *const __is_compile_time_constant_uniform_int32;
 extern const char *const __is_compile_time_constant_varying_int32;
@@ -162,10 +163,13 @@ extern const char *const __ispc_amx_tile_load;
 extern const char *const __ispc_amx_tile_load_t1;
 extern const char *const __ispc_amx_tile_store;
 extern const char *const __ispc_amx_tile_zero;
+extern const char *const __ispc_dispatch_max_isa;
 extern const char *const ISPCAlloc;
 extern const char *const ISPCLaunch;
 extern const char *const ISPCSync;
 extern const char *const ISPCInstrument;
+extern const char *const ISPCGetDispatchISA;
+extern const char *const ISPCSetDispatchMaxISA;
 extern const char *const __masked_load_blend_double;
 extern const char *const __masked_load_blend_float;
 extern const char *const __masked_load_blend_half;
@@ -22,13 +22,16 @@
 #include <math.h>
 #include <stdlib.h>
 
+#include <memory>
 #include <unordered_set>
+#include <vector>
 
 #include <llvm/ADT/StringRef.h>
 #include <llvm/ADT/StringSet.h>
 #include <llvm/Bitcode/BitcodeReader.h>
 #include <llvm/IR/Attributes.h>
 #include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/InstIterator.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/Intrinsics.h>
 #include <llvm/IR/LLVMContext.h>
@@ -136,6 +139,98 @@ void lSetInternalLinkageGlobals(llvm::Module *module) {
     }
 }
 
+// Report an error of bitcode library materialization.
+static bool lCheckMaterialization(llvm::Error err) {
+    if (err) {
+        Error(SourcePos(), "Error loading bitcode library: %s", llvm::toString(std::move(err)).c_str());
+        return false;
+    }
+    return true;
+}
+
+// Collect functions referenced from the constant (e.g., a global variable
+// initializer or a constant expression operand of an instruction).
+static void lCollectReferencedFunctions(const llvm::Constant *C, std::unordered_set<const llvm::Constant *> &visited,
+                                        std::vector<llvm::Function *> &worklist) {
+    if (!visited.insert(C).second) {
+        return;
+    }
+    if (auto *F = llvm::dyn_cast<llvm::Function>(C)) {
+        worklist.push_back(const_cast<llvm::Function *>(F));
+        return;
+    }
+    if (auto *GV = llvm::dyn_cast<llvm::GlobalVariable>(C)) {
+        if (GV->hasInitializer()) {
+            lCollectReferencedFunctions(GV->getInitializer(), visited, worklist);
+        }
+        return;
+    }
+    if (auto *GA = llvm::dyn_cast<llvm::GlobalAlias>(C)) {
+        lCollectReferencedFunctions(GA->getAliasee(), visited, worklist);
+        return;
+    }
+    for (const llvm::Use &op : C->operands()) {
+        if (auto *opC = llvm::dyn_cast<llvm::Constant>(op.get())) {
+            lCollectReferencedFunctions(opC, visited, worklist);
+        }
+    }
+}
+
+// Library modules are loaded lazily (see BitcodeLib::getLLVMModule()).
+// Materialize the bodies of the functions that are going to be linked to
+// the module with LinkOnlyNeeded: the ones declared in the module and,
+// transitively, the ones they reference. Other bodies are never read, and
+// the number of uses of the library declarations reflects only the code
+// that is going to be linked.
+static void lMaterializeNeeded(llvm::Module *bcModule, llvm::Module *module) {
+    if (bcModule->isMaterialized()) {
+        Debug(SourcePos(), "All function bodies of bitcode library \"%s\" are materialized.",
+              bcModule->getModuleIdentifier().c_str());
+        return;
+    }
+
+    std::vector<llvm::Function *> worklist;
+    std::unordered_set<const llvm::Constant *> visited;
+    int numMaterializable = 0;
+    int numMaterialized = 0;
+    for (llvm::Function &F : *bcModule) {
+        if (!F.isMaterializable()) {
+            continue;
+        }
+        ++numMaterializable;
+        if (module->getFunction(F.getName())) {
+            worklist.push_back(&F);
+        }
+    }
+    // Appending variables such as llvm.used are always linked.
+    for (llvm::GlobalVariable &GV : bcModule->globals()) {
+        if (GV.hasAppendingLinkage()) {
+            lCollectReferencedFunctions(&GV, visited, worklist);
+        }
+    }
+
+    while (!worklist.empty()) {
+        llvm::Function *F = worklist.back();
+        worklist.pop_back();
+        if (!F->isMaterializable()) {
+            continue;
+        }
+        if (!lCheckMaterialization(F->materialize())) {
+            return;
+        }
+        ++numMaterialized;
+        for (llvm::Instruction &I : llvm::instructions(*F)) {
+            for (const llvm::Use &op : I.operands()) {
+                if (auto *C = llvm::dyn_cast<llvm::Constant>(op.get())) {
+                    lCollectReferencedFunctions(C, visited, worklist);
+                }
+            }
+        }
+    }
+    Debug(SourcePos(), "Materialized %d of %d function bodies of bitcode library \"%s\".", numMaterialized,
+          numMaterializable, bcModule->getModuleIdentifier().c_str());
+}
+
 void lAddBitcodeToModule(llvm::Module *bcModule, llvm::Module *module) {
     if (!bcModule) {
         Error(SourcePos(), "Error library module is nullptr");
@@ -148,6 +243,8 @@ void lAddBitcodeToModule(llvm::Module *bcModule, llvm::Module *module) {
             lUpdateIntrinsicsAttributes(bcModule);
         }
 
+        lMaterializeNeeded(bcModule, module);
+
         for (llvm::Function &f : *bcModule) {
             if (f.isDeclaration()) {
                 // Declarations with uses will be moved by Linker.
@@ -401,8 +498,35 @@ void ispc::LinkDispatcher(llvm::Module *module) {
     llvm::Module *dispatchBCModule = dispatch->getLLVMModule();
     lAddDeclarationsToModule(dispatchBCModule, module);
     lAddBitcodeToModule(dispatchBCModule, module);
-    llvm::StringSet<> dispatchFunctions = {builtin::__get_system_best_isa, builtin::__terminate_now};
+    llvm::StringSet<> dispatchFunctions = {builtin::__get_system_best_isa, builtin::__get_system_best_isa_ifunc,
+                                           builtin::__terminate_now};
     lSetAsInternal(module, dispatchFunctions);
+
+    // Only the resolvers of --dispatch=ifunc use it, and it references
+    // 'environ' that doesn't exist on all the systems.
+    if (g->dispatchMode != Globals::DispatchMode::IFunc) {
+        if (llvm::Function *F = module->getFunction(builtin::__get_system_best_isa_ifunc)) {
+            F->eraseFromParent();
+        }
+    }
+
+    // The limit of the dispatch ISA and the functions that control it are
+    // shared by the dispatch modules of all the translation units, so every
+    // dispatch module has a weak definition of them.
+    llvm::Triple triple(module->getTargetTriple());
+    for (const char *name : {builtin::__ispc_dispatch_max_isa, builtin::ISPCSetDispatchMaxISA,
+                             builtin::ISPCGetDispatchISA}) {
+        llvm::GlobalValue *GV = module->getNamedValue(name);
+        if (GV == nullptr || GV->isDeclaration()) {
+            continue;
+        }
+        GV->setLinkage(llvm::GlobalValue::WeakODRLinkage);
+        if (triple.supportsCOMDAT()) {
+            if (auto *GO = llvm::dyn_cast<llvm::GlobalObject>(GV)) {
+                GO->setComdat(module->getOrInsertComdat(name));
+            }
+        }
+    }
 }
 
 void lLinkCommonBuiltins(llvm::Module *module) {
@@ -613,7 +737,12 @@ void lCollectAllDefinedFunctions(ISPCTarget target, llvm::StringSet<> &definedFu
     for (ISPCTarget t = target; t != ISPCTarget::none; t = GetParentTarget(t)) {
         rootTarget = t;
     }
-    llvm::Module *m = lGetTargetBCModule(rootTarget);
+    std::unique_ptr<llvm::Module> m(lGetTargetBCModule(rootTarget));
+    if (!m) {
+        return;
+    }
+    // Function bodies are not materialized here, so only the declarations
+    // are read from the bitcode. Materializable functions are definitions.
     for (llvm::Function &F : m->functions()) {
         auto name = F.getName();
         if (!lStartsWithLLVM(name) && !F.isDeclaration()) {
@@ -684,6 +813,12 @@ void lLinkStdlib(llvm::Module *module) {
         }
     }
 
+    // Setting the calling convention below needs to see all calls to the
+    // stdlib functions, so materialize the whole library in this case.
+    if (g->calling_conv == CallingConv::x86_vectorcall) {
+        lCheckMaterialization(stdlibBCModule->materializeAll());
+    }
+
     llvm::StringSet<> stdlibFunctions;
     for (llvm::Function &F : stdlibBCModule->functions()) {
         // If compiling with --vectorcall then set calling convention of all
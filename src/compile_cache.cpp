@@ -0,0 +1,428 @@
+/*
+  Copyright (c) 2026, Intel Corporation
+
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+/** @file compile_cache.cpp
+    @brief Implementation of the persistent compilation cache.
+*/
+
+#include "compile_cache.h"
+#include "ispc.h"
+#include "ispc_version.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <stdio.h>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/SHA256.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace ispc;
+
+// Bump it when the layout of the cache directory or the way the key is
+// computed changes.
+static const char *lCacheFormatVersion = "ispc-cache-1";
+
+static const char *lManifestName = "manifest";
+static const char *lStatsName = "stats";
+
+CompilationCache::CompilationCache(const std::string &dir) : m_dir(dir) {}
+
+/** Returns a string that changes when the given file is replaced: its path,
+    size and modification time. Hashing the content of the compiler binary
+    on every compilation would cost more than most cache hits save. */
+static std::string lFileStamp(const std::string &path) {
+    llvm::sys::fs::file_status status;
+    if (llvm::sys::fs::status(path, status)) {
+        return path + ":missing";
+    }
+    return path + ":" + std::to_string(status.getSize()) + ":" +
+           std::to_string(status.getLastModificationTime().time_since_epoch().count());
+}
+
+/** Returns the stamps of the files the compiler output depends on besides
+    its inputs: the compiler binary (which has the bitcode libraries built in
+    for the composite binary) and, for the slim binary, the bitcode libraries
+    in the share directory. Dev builds can have the same version string, so
+    the version alone doesn't identify the compiler. */
+static std::vector<std::string> lCompilerStamps() {
+    std::vector<std::string> stamps;
+    // Any function of this library does for locating the binary.
+    stamps.push_back(lFileStamp(llvm::sys::fs::getMainExecutable(nullptr, (void *)(intptr_t)lFileStamp)));
+    if (g->isSlimBinary && !g->shareDirPath.empty()) {
+        std::error_code ec;
+        std::vector<std::string> libs;
+        for (llvm::sys::fs::directory_iterator it(g->shareDirPath, ec), end; it != end && !ec; it.increment(ec)) {
+            libs.push_back(it->path());
+        }
+        std::sort(libs.begin(), libs.end());
+        for (const std::string &lib : libs) {
+            stamps.push_back(lFileStamp(lib));
+        }
+    }
+    return stamps;
+}
+
+std::string CompilationCache::entryPath() const {
+    llvm::SmallString<256> path(m_dir);
+    llvm::sys::path::append(path, m_key.substr(0, 2), m_key);
+    return std::string(path.str());
+}
+
+bool CompilationCache::Prepare(const char *srcFile, Arch arch, const char *cpu, const std::vector<ISPCTarget> &targets,
+                               const Module::Output &output) {
+    m_key.clear();
+    m_outputs.clear();
+    m_interfaceOutputs.clear();
+
+    // Outputs and inputs that can't be stored or hashed.
+    if (m_dir.empty() || IsStdin(srcFile) || output.out == "-" || output.flags.isDepsToStdout() || g->onlyCPP ||
+        g->enableTimeTrace || !g->compileReportFile.empty() || !g->runCPP) {
+        return false;
+    }
+
+    llvm::SHA256 hasher;
+    auto hashString = [&hasher](llvm::StringRef str) {
+        hasher.update(str);
+        hasher.update(llvm::StringRef("\0", 1));
+    };
+
+    hashString(lCacheFormatVersion);
+    hashString(ISPC_VERSION_STRING);
+    static const std::vector<std::string> compilerStamps = lCompilerStamps();
+    for (const std::string &stamp : compilerStamps) {
+        hashString(stamp);
+    }
+    hashString(g->currentDirectory);
+    for (const std::string &arg : g->cacheKeyArgs) {
+        hashString(arg);
+    }
+
+    const bool isMultiTarget = targets.size() > 1;
+    std::vector<ISPCTarget> keyTargets(targets);
+    if (keyTargets.empty()) {
+        keyTargets.push_back(ISPCTarget::none);
+    }
+
+    // The preprocessed source is target dependent (e.g. ISPC_TARGET_* macros
+    // may guard #include directives), so run the preprocessor for every
+    // target. Target and Module set up the global state used by it.
+    // Diagnostics of Target::Create() and of the preprocessor are reported
+    // by the compilation that follows, so they are suppressed here.
+    Target *savedTarget = g->target;
+    Module *savedModule = m;
+    bool savedQuiet = g->quiet;
+    bool savedIgnoreCPPErrors = g->ignoreCPPErrors;
+    g->quiet = true;
+    g->ignoreCPPErrors = true;
+    bool success = true;
+    for (ISPCTarget target : keyTargets) {
+        auto targetPtr =
+            Target::Create(arch, cpu, target, output.flags.getPICLevel(), output.flags.getMCModel(), false);
+        if (!targetPtr) {
+            success = false;
+            break;
+        }
+
+        std::string preprocessed;
+        {
+            Module module(srcFile);
+            m = &module;
+            module.Preprocess(preprocessed);
+        }
+
+        hashString(preprocessed);
+
+        if (isMultiTarget) {
+            if (!output.out.empty()) {
+                m_outputs.push_back(output.OutFileNameTarget(targetPtr.get()));
+            }
+            if (!output.header.empty()) {
+                m_outputs.push_back(output.HeaderFileNameTarget(targetPtr.get()));
+                m_interfaceOutputs.push_back(m_outputs.back());
+            }
+        }
+        g->target = nullptr;
+    }
+    g->target = savedTarget;
+    m = savedModule;
+    g->quiet = savedQuiet;
+    g->ignoreCPPErrors = savedIgnoreCPPErrors;
+
+    if (!success) {
+        m_outputs.clear();
+        return false;
+    }
+
+    for (const std::string *name : {&output.out, &output.header, &output.nbWrap, &output.deps, &output.fingerprint}) {
+        if (!name->empty()) {
+            m_outputs.push_back(*name);
+        }
+    }
+    for (const std::string *name : {&output.header, &output.fingerprint}) {
+        if (!name->empty()) {
+            m_interfaceOutputs.push_back(*name);
+        }
+    }
+    if (!isMultiTarget) {
+        for (const std::string *name : {&output.hostStub, &output.devStub}) {
+            if (!name->empty()) {
+                m_outputs.push_back(*name);
+            }
+        }
+    }
+    // Nothing to cache.
+    if (m_outputs.empty()) {
+        return false;
+    }
+
+    m_key = llvm::toHex(hasher.final(), /* LowerCase */ true);
+    return true;
+}
+
+bool CompilationCache::Lookup() {
+    if (m_key.empty()) {
+        return false;
+    }
+
+    std::string entry = entryPath();
+    llvm::SmallString<256> manifestPath(entry);
+    llvm::sys::path::append(manifestPath, lManifestName);
+
+    auto manifest = llvm::MemoryBuffer::getFile(manifestPath);
+    if (!manifest) {
+        updateStats(false);
+        return false;
+    }
+
+    // The key covers the command line, so the stored outputs are expected to
+    // be exactly the requested ones; check it anyway.
+    llvm::SmallVector<llvm::StringRef, 8> lines;
+    (*manifest)->getBuffer().split(lines, '\n', -1, false);
+    if (lines.size() != m_outputs.size() || !std::equal(lines.begin(), lines.end(), m_outputs.begin())) {
+        updateStats(false);
+        return false;
+    }
+
+    for (size_t i = 0; i < m_outputs.size(); ++i) {
+        llvm::SmallString<256> cached(entry);
+        llvm::sys::path::append(cached, std::to_string(i));
+        // Like the compiler itself, keep the headers that didn't change.
+        bool isInterface = std::find(m_interfaceOutputs.begin(), m_interfaceOutputs.end(), m_outputs[i]) !=
+                           m_interfaceOutputs.end();
+        if (isInterface && FilesAreEqual(std::string(cached.str()), m_outputs[i])) {
+            continue;
+        }
+        if (std::error_code ec = llvm::sys::fs::copy_file(cached, m_outputs[i])) {
+            Warning(SourcePos(), "Failed to restore \"%s\" from compilation cache: %s.", m_outputs[i].c_str(),
+                    ec.message().c_str());
+            updateStats(false);
+            return false;
+        }
+    }
+
+    // Refresh the modification time of the manifest, it is used for the
+    // least recently used eviction.
+    int fd = -1;
+    if (!llvm::sys::fs::openFileForWrite(manifestPath, fd, llvm::sys::fs::CD_OpenExisting, llvm::sys::fs::OF_Append)) {
+        llvm::sys::fs::setLastAccessAndModificationTime(fd, std::chrono::system_clock::now());
+        llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+    }
+
+    updateStats(true);
+    return true;
+}
+
+void CompilationCache::Store() {
+    if (m_key.empty()) {
+        return;
+    }
+
+    // Populate the entry in a temporary directory and then move it in place,
+    // so concurrent compilations never see an incomplete entry.
+    llvm::SmallString<256> tmpDir(m_dir);
+    llvm::sys::path::append(tmpDir, "tmp");
+    if (llvm::sys::fs::create_directories(tmpDir)) {
+        return;
+    }
+    llvm::sys::path::append(tmpDir, m_key);
+    llvm::SmallString<256> tmpEntry;
+    if (llvm::sys::fs::createUniqueDirectory(tmpDir, tmpEntry)) {
+        return;
+    }
+
+    std::string manifest;
+    bool success = true;
+    for (size_t i = 0; i < m_outputs.size() && success; ++i) {
+        llvm::SmallString<256> cached(tmpEntry);
+        llvm::sys::path::append(cached, std::to_string(i));
+        success = !llvm::sys::fs::copy_file(m_outputs[i], cached);
+        manifest += m_outputs[i] + "\n";
+    }
+
+    if (success) {
+        llvm::SmallString<256> manifestPath(tmpEntry);
+        llvm::sys::path::append(manifestPath, lManifestName);
+        std::error_code ec;
+        llvm::raw_fd_ostream os(manifestPath, ec, llvm::sys::fs::OF_Text);
+        if (!ec) {
+            os << manifest;
+        }
+        os.close();
+        success = !ec && !os.has_error();
+    }
+
+    std::string entry = entryPath();
+    if (success && !llvm::sys::fs::create_directories(llvm::sys::path::parent_path(entry)) &&
+        !llvm::sys::fs::rename(tmpEntry, entry)) {
+        trim();
+        return;
+    }
+
+    // Either something went wrong or another process has already stored the
+    // same entry.
+    llvm::sys::fs::remove_directories(tmpEntry);
+}
+
+namespace {
+struct CacheStats {
+    uint64_t hits{0};
+    uint64_t misses{0};
+};
+
+struct CacheEntry {
+    std::string path;
+    uint64_t size{0};
+    llvm::sys::TimePoint<> lastUse;
+};
+} // namespace
+
+static CacheStats lReadStats(const std::string &dir) {
+    CacheStats stats;
+    llvm::SmallString<256> path(dir);
+    llvm::sys::path::append(path, lStatsName);
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer) {
+        return stats;
+    }
+    llvm::SmallVector<llvm::StringRef, 4> lines;
+    (*buffer)->getBuffer().split(lines, '\n', -1, false);
+    for (llvm::StringRef line : lines) {
+        auto [name, value] = line.split(' ');
+        if (name == "hits") {
+            value.trim().getAsInteger(10, stats.hits);
+        } else if (name == "misses") {
+            value.trim().getAsInteger(10, stats.misses);
+        }
+    }
+    return stats;
+}
+
+// Collects all complete entries of the cache in the given directory.
+static std::vector<CacheEntry> lCollectEntries(const std::string &dir) {
+    std::vector<CacheEntry> entries;
+    std::error_code ec;
+    for (llvm::sys::fs::directory_iterator prefix(dir, ec), end; prefix != end && !ec; prefix.increment(ec)) {
+        if (llvm::sys::path::filename(prefix->path()).size() != 2) {
+            continue;
+        }
+        for (llvm::sys::fs::directory_iterator entry(prefix->path(), ec); entry != end && !ec; entry.increment(ec)) {
+            CacheEntry cacheEntry;
+            cacheEntry.path = entry->path();
+
+            llvm::SmallString<256> manifestPath(cacheEntry.path);
+            llvm::sys::path::append(manifestPath, lManifestName);
+            llvm::sys::fs::file_status manifestStatus;
+            if (llvm::sys::fs::status(manifestPath, manifestStatus)) {
+                continue;
+            }
+            cacheEntry.lastUse = manifestStatus.getLastModificationTime();
+
+            std::error_code fileEC;
+            for (llvm::sys::fs::directory_iterator file(cacheEntry.path, fileEC); file != end && !fileEC;
+                 file.increment(fileEC)) {
+                llvm::sys::fs::file_status fileStatus;
+                if (!llvm::sys::fs::status(file->path(), fileStatus)) {
+                    cacheEntry.size += fileStatus.getSize();
+                }
+            }
+            entries.push_back(cacheEntry);
+        }
+        ec.clear();
+    }
+    return entries;
+}
+
+void CompilationCache::updateStats(bool hit) const {
+    // Counters are updated without locking, so concurrent compilations may
+    // occasionally lose an update. They are informational only.
+    CacheStats stats = lReadStats(m_dir);
+    if (hit) {
+        stats.hits++;
+    } else {
+        stats.misses++;
+    }
+
+    if (llvm::sys::fs::create_directories(m_dir)) {
+        return;
+    }
+    llvm::SmallString<256> path(m_dir);
+    llvm::sys::path::append(path, lStatsName);
+    std::error_code ec;
+    llvm::raw_fd_ostream os(path, ec, llvm::sys::fs::OF_Text);
+    if (ec) {
+        return;
+    }
+    os << "hits " << stats.hits << "\n";
+    os << "misses " << stats.misses << "\n";
+}
+
+void CompilationCache::trim() const {
+    std::vector<CacheEntry> entries = lCollectEntries(m_dir);
+    uint64_t totalSize = 0;
+    for (const CacheEntry &entry : entries) {
+        totalSize += entry.size;
+    }
+    if (totalSize <= g->cacheMaxSize) {
+        return;
+    }
+
+    // Evict the least recently used entries until the cache is 10% below
+    // the limit, so trimming doesn't happen on every store.
+    std::sort(entries.begin(), entries.end(),
+              [](const CacheEntry &a, const CacheEntry &b) { return a.lastUse < b.lastUse; });
+    uint64_t targetSize = g->cacheMaxSize - g->cacheMaxSize / 10;
+    for (const CacheEntry &entry : entries) {
+        if (totalSize <= targetSize) {
+            break;
+        }
+        if (!llvm::sys::fs::remove_directories(entry.path)) {
+            totalSize -= entry.size;
+        }
+    }
+}
+
+void CompilationCache::PrintStats(const std::string &dir) {
+    CacheStats stats = lReadStats(dir);
+    std::vector<CacheEntry> entries = lCollectEntries(dir);
+    uint64_t totalSize = 0;
+    for (const CacheEntry &entry : entries) {
+        totalSize += entry.size;
+    }
+
+    printf("Cache directory: %s\n", dir.c_str());
+    printf("Hits:            %" PRIu64 "\n", stats.hits);
+    printf("Misses:          %" PRIu64 "\n", stats.misses);
+    printf("Entries:         %zu\n", entries.size());
+    printf("Size:            %.1f MB (limit %.1f MB)\n", totalSize / (1024.0 * 1024.0),
+           g->cacheMaxSize / (1024.0 * 1024.0));
+}
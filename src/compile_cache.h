@@ -0,0 +1,76 @@
+/*
+  Copyright (c) 2026, Intel Corporation
+
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+/** @file compile_cache.h
+    @brief Persistent on-disk cache of compilation outputs (see --cache-dir).
+*/
+
+#pragma once
+
+#include "module.h"
+#include "target_enums.h"
+
+#include <string>
+#include <vector>
+
+namespace ispc {
+
+/** @class CompilationCache
+    Content-addressed cache of the files produced by a compilation.
+
+    The key is a hash of the compiler version, the command-line arguments,
+    the working directory and the preprocessed source for every requested
+    target. On a hit, the stored object/assembly/bitcode, header, dispatch
+    and dependency files are copied to the requested output paths instead
+    of compiling the source. Diagnostics are not stored, so warnings are not
+    repeated on a hit.
+
+    The cache directory has the following layout:
+        <dir>/<first two key chars>/<key>/manifest  list of cached outputs
+        <dir>/<first two key chars>/<key>/<N>       content of N-th output
+        <dir>/stats                                 hit/miss counters
+    Entries are evicted in least-recently-used order once the total size of
+    the cache exceeds g->cacheMaxSize.
+ */
+class CompilationCache {
+  public:
+    explicit CompilationCache(const std::string &dir);
+
+    /** Computes the cache key for the compilation of srcFile with the given
+        parameters. Returns false if the compilation can't be cached, e.g.
+        because the source is read from stdin or the output goes to stdout.
+        Lookup() and Store() do nothing in this case. */
+    bool Prepare(const char *srcFile, Arch arch, const char *cpu, const std::vector<ISPCTarget> &targets,
+                 const Module::Output &output);
+
+    /** Copies the cached outputs to their destinations. Returns true on a
+        cache hit. */
+    bool Lookup();
+
+    /** Puts the outputs of a successful compilation to the cache. */
+    void Store();
+
+    /** Prints hit/miss statistics and the size of the cache in the given
+        directory. */
+    static void PrintStats(const std::string &dir);
+
+  private:
+    std::string m_dir;
+    std::string m_key;
+
+    /** Output files produced by the compilation, in a stable order. */
+    std::vector<std::string> m_outputs;
+
+    /** Headers and the interface fingerprint among the outputs. They are not
+        overwritten on a hit if they already have the cached content. */
+    std::vector<std::string> m_interfaceOutputs;
+
+    std::string entryPath() const;
+    void updateStats(bool hit) const;
+    void trim() const;
+};
+
+} // namespace ispc
@@ -0,0 +1,188 @@
+/*
+  Copyright (c) 2026, Intel Corporation
+
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+/** @file compile_report.cpp
+    @brief Implementation of the per-phase compile time and memory report.
+*/
+
+#include "compile_report.h"
+#include "ispc.h"
+#include "target_enums.h"
+
+#include <algorithm>
+#include <memory>
+
+#include <llvm/IR/PassInstrumentation.h>
+#include <llvm/Passes/StandardInstrumentations.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+#ifdef ISPC_HOST_IS_WINDOWS
+#include <windows.h>
+// windows.h has to be included before psapi.h.
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace ispc;
+
+// Returns the peak resident set size of the process in bytes or 0 if it is
+// not available.
+static uint64_t lGetPeakRSS() {
+#ifdef ISPC_HOST_IS_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef ISPC_HOST_IS_APPLE
+    // Bytes on macOS.
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+    // Kilobytes on Linux and FreeBSD.
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif // ISPC_HOST_IS_WINDOWS
+}
+
+static double lSecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+CompileReport::TargetReport &CompileReport::getTarget(const std::string &target) {
+    for (TargetReport &report : m_targets) {
+        if (report.target == target) {
+            return report;
+        }
+    }
+    m_targets.push_back(TargetReport{target, {}, {}, {}});
+    return m_targets.back();
+}
+
+void CompileReport::addTime(std::vector<Counter> &counters, const std::string &name, double seconds) {
+    auto it = std::find_if(counters.begin(), counters.end(), [&name](const Counter &c) { return c.name == name; });
+    if (it == counters.end()) {
+        counters.push_back(Counter{name, seconds, 1});
+    } else {
+        it->seconds += seconds;
+        it->runs++;
+    }
+}
+
+void CompileReport::AddPhaseTime(const std::string &target, const std::string &phase, double seconds) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    addTime(getTarget(target).phases, phase, seconds);
+}
+
+void CompileReport::AddPassTime(const std::string &target, const std::string &pass, double seconds) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    addTime(getTarget(target).passes, pass, seconds);
+}
+
+void CompileReport::SetInstructionCount(const std::string &target, const std::string &stage, uint64_t count) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto &instructions = getTarget(target).instructions;
+    auto it =
+        std::find_if(instructions.begin(), instructions.end(), [&stage](const auto &c) { return c.first == stage; });
+    if (it == instructions.end()) {
+        instructions.push_back({stage, count});
+    } else {
+        it->second = count;
+    }
+}
+
+void CompileReport::RegisterPassCallbacks(llvm::PassInstrumentationCallbacks &PIC, const std::string &target) {
+    // Passes may be nested (a function pass runs inside an adaptor), so the
+    // start times are kept on a stack. Pass managers and adaptors are not
+    // reported, otherwise the time of the passes they run would be counted
+    // twice; this is the same set of passes that -time-passes skips.
+    auto starts = std::make_shared<std::vector<std::chrono::steady_clock::time_point>>();
+    auto isReported = [](llvm::StringRef pass) {
+        return !llvm::isSpecialPass(pass, {"PassManager", "PassAdaptor", "AnalysisManagerProxy",
+                                           "ModuleInlinerWrapperPass", "DevirtSCCRepeatedPass"});
+    };
+    auto finish = [this, target, starts, isReported](llvm::StringRef pass) {
+        if (starts->empty()) {
+            return;
+        }
+        double seconds = lSecondsSince(starts->back());
+        starts->pop_back();
+        if (isReported(pass)) {
+            AddPassTime(target, pass.str(), seconds);
+        }
+    };
+
+    PIC.registerBeforeNonSkippedPassCallback(
+        [starts](llvm::StringRef, llvm::Any) { starts->push_back(std::chrono::steady_clock::now()); });
+    PIC.registerAfterPassCallback(
+        [finish](llvm::StringRef pass, llvm::Any, const llvm::PreservedAnalyses &) { finish(pass); });
+    PIC.registerAfterPassInvalidatedCallback(
+        [finish](llvm::StringRef pass, const llvm::PreservedAnalyses &) { finish(pass); });
+}
+
+bool CompileReport::Write(const std::string &fileName, const std::string &srcFile, double totalSeconds) const {
+    std::error_code EC;
+    llvm::raw_fd_ostream os(fileName, EC, llvm::sys::fs::OF_Text);
+    if (EC) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    llvm::json::OStream json(os, 2);
+    json.object([&] {
+        json.attribute("file", srcFile);
+        json.attribute("total_time_sec", totalSeconds);
+        json.attribute("peak_rss_bytes", static_cast<int64_t>(lGetPeakRSS()));
+        json.attributeArray("targets", [&] {
+            for (const TargetReport &report : m_targets) {
+                json.object([&] {
+                    json.attribute("target", report.target);
+                    json.attributeObject("phases", [&] {
+                        for (const Counter &phase : report.phases) {
+                            json.attribute(phase.name, phase.seconds);
+                        }
+                    });
+                    // The most expensive passes go first.
+                    std::vector<Counter> passes(report.passes);
+                    std::stable_sort(passes.begin(), passes.end(),
+                                     [](const Counter &a, const Counter &b) { return a.seconds > b.seconds; });
+                    json.attributeArray("passes", [&] {
+                        for (const Counter &pass : passes) {
+                            json.object([&] {
+                                json.attribute("name", pass.name);
+                                json.attribute("time_sec", pass.seconds);
+                                json.attribute("runs", static_cast<int64_t>(pass.runs));
+                            });
+                        }
+                    });
+                    json.attributeObject("instructions", [&] {
+                        for (const auto &count : report.instructions) {
+                            json.attribute(count.first, static_cast<int64_t>(count.second));
+                        }
+                    });
+                });
+            }
+        });
+    });
+    os << "\n";
+    return !os.has_error();
+}
+
+CompileReportScope::CompileReportScope(const char *phase) : m_phase(phase), m_start(std::chrono::steady_clock::now()) {}
+
+CompileReportScope::~CompileReportScope() {
+    if (g->compileReport) {
+        std::string target = g->target ? ISPCTargetToString(g->target->getISPCTarget()) : std::string();
+        g->compileReport->AddPhaseTime(target, m_phase, lSecondsSince(m_start));
+    }
+}
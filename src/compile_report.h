@@ -0,0 +1,98 @@
+/*
+  Copyright (c) 2026, Intel Corporation
+
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+/** @file compile_report.h
+    @brief Per-phase compile time and memory report (see --compile-report).
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace llvm {
+class PassInstrumentationCallbacks;
+}
+
+namespace ispc {
+
+/** @class CompileReport
+    Aggregated statistics of the compilation of one source file: time spent
+    in every compilation phase and in every optimization pass, and the number
+    of IR instructions before and after optimization, all per target, plus
+    the peak resident set size of the process. The report is written as JSON
+    so that it can be consumed by build dashboards.
+
+    Code generation of multi-target compilation may run on worker threads, so
+    all the methods are thread-safe.
+ */
+class CompileReport {
+  public:
+    /** Adds the time spent in a compilation phase, e.g. "parse". */
+    void AddPhaseTime(const std::string &target, const std::string &phase, double seconds);
+
+    /** Adds the time spent in one run of an optimization pass. */
+    void AddPassTime(const std::string &target, const std::string &pass, double seconds);
+
+    /** Records the number of IR instructions at the given stage of the
+        compilation, e.g. "before_optimization". */
+    void SetInstructionCount(const std::string &target, const std::string &stage, uint64_t count);
+
+    /** Registers callbacks measuring every pass run through the pass
+        managers that use the given instrumentation. The report must outlive
+        the pass managers. */
+    void RegisterPassCallbacks(llvm::PassInstrumentationCallbacks &PIC, const std::string &target);
+
+    /** Writes the report for srcFile to fileName. Returns false if the file
+        can't be written. */
+    bool Write(const std::string &fileName, const std::string &srcFile, double totalSeconds) const;
+
+  private:
+    struct Counter {
+        std::string name;
+        double seconds;
+        unsigned runs;
+    };
+
+    struct TargetReport {
+        std::string target;
+        std::vector<Counter> phases;
+        std::vector<Counter> passes;
+        std::vector<std::pair<std::string, uint64_t>> instructions;
+    };
+
+    /** Returns the report of the target, creating it on first use. The caller
+        must hold m_mutex. */
+    TargetReport &getTarget(const std::string &target);
+
+    static void addTime(std::vector<Counter> &counters, const std::string &name, double seconds);
+
+    mutable std::mutex m_mutex;
+    std::vector<TargetReport> m_targets;
+};
+
+/** @class CompileReportScope
+    Adds the time between construction and destruction to the given phase of
+    the current target (g->target) in g->compileReport. Does nothing if the
+    report is not requested.
+ */
+class CompileReportScope {
+  public:
+    explicit CompileReportScope(const char *phase);
+    ~CompileReportScope();
+
+    CompileReportScope(const CompileReportScope &) = delete;
+    CompileReportScope &operator=(const CompileReportScope &) = delete;
+
+  private:
+    const char *m_phase;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace ispc
@@ -1364,7 +1364,7 @@ void FunctionEmitContext::SetFunctionFTZ_DAZFlags() {
     std::vector<Symbol *> mm;
     m->symbolTable->LookupFunction(builtin::__set_ftz_daz_flags, &mm);
     AssertPos(currentPos, mm.size() >= 1);
-    llvm::Function *fmm = mm[0]->function;
+    llvm::Function *fmm = mm[0]->GetFunction();
     std::vector<llvm::Value *> args;
     llvm::Value *oldFTZ = CallInst(fmm, nullptr, args, "");
     StoreInst(oldFTZ, functionFTZ_DAZValue);
@@ -1377,7 +1377,7 @@ void FunctionEmitContext::RestoreFunctionFTZ_DAZFlags() {
     std::vector<Symbol *> mm;
     m->symbolTable->LookupFunction(builtin::__restore_ftz_daz_flags, &mm);
     AssertPos(currentPos, mm.size() >= 1);
-    llvm::Function *fmm = mm[0]->function;
+    llvm::Function *fmm = mm[0]->GetFunction();
     llvm::Value *oldFTZ = LoadInst(functionFTZ_DAZValue);
     std::vector<llvm::Value *> args;
     args.push_back(oldFTZ);
@@ -1390,7 +1390,7 @@ llvm::Value *FunctionEmitContext::Any(llvm::Value *mask) {
     std::vector<Symbol *> mm;
     m->symbolTable->LookupFunction(builtin::__any, &mm);
     AssertPos(currentPos, mm.size() == 1);
-    llvm::Function *fmm = mm[0]->function;
+    llvm::Function *fmm = mm[0]->GetFunction();
     return CallInst(fmm, nullptr, mask, llvm::Twine(mask->getName()) + "_any");
 }
 
@@ -1400,7 +1400,7 @@ llvm::Value *FunctionEmitContext::All(llvm::Value *mask) {
     std::vector<Symbol *> mm;
     m->symbolTable->LookupFunction(builtin::__all, &mm);
     AssertPos(currentPos, mm.size() == 1);
-    llvm::Function *fmm = mm[0]->function;
+    llvm::Function *fmm = mm[0]->GetFunction();
     return CallInst(fmm, nullptr, mask, llvm::Twine(mask->getName()) + "_all");
 }
 
@@ -1410,7 +1410,7 @@ llvm::Value *FunctionEmitContext::None(llvm::Value *mask) {
     std::vector<Symbol *> mm;
     m->symbolTable->LookupFunction(builtin::__none, &mm);
     AssertPos(currentPos, mm.size() == 1);
-    llvm::Function *fmm = mm[0]->function;
+    llvm::Function *fmm = mm[0]->GetFunction();
     return CallInst(fmm, nullptr, mask, llvm::Twine(mask->getName()) + "_none");
 }
 
@@ -1420,7 +1420,7 @@ llvm::Value *FunctionEmitContext::LaneMask(llvm::Value *v) {
     std::vector<Symbol *> mm;
     m->symbolTable->LookupFunction(builtin::__movmsk, &mm);
     AssertPos(currentPos, mm.size() == 1);
-    llvm::Function *fmm = mm[0]->function;
+    llvm::Function *fmm = mm[0]->GetFunction();
     return CallInst(fmm, nullptr, v, llvm::Twine(v->getName()) + "_movmsk");
 }
 
@@ -1781,7 +1781,7 @@ llvm::Value *FunctionEmitContext::VectorIntDivision(llvm::Instruction::BinaryOps
     m->symbolTable->LookupFunction(funcName.c_str(), &candidates);
     AssertPos(currentPos, candidates.size() == 1 && "No matching function found for __[s|u]div or _[s|u]rem");
 
-    llvm::Function *match = candidates[0]->function;
+    llvm::Function *match = candidates[0]->GetFunction();
     llvm::Value *callDiv = CallInst(match, nullptr, {v0, v1, mask}, name + funcName);
     BranchInst(postDivBlock);
 
@@ -2820,11 +2820,11 @@ llvm::Value *FunctionEmitContext::LoadInst(llvm::Value *ptr, llvm::Value *mask,
         std::vector<Symbol *> mm;
         m->symbolTable->LookupFunction(builtin::__movmsk, &mm);
         AssertPos(currentPos, mm.size() == 1);
-        llvm::Function *fmm = mm[0]->function;
+        llvm::Function *fmm = mm[0]->GetFunction();
         llvm::Value *int_mask = CallInst(fmm, nullptr, mask, llvm::Twine(mask->getName()) + "_movmsk");
         std::vector<Symbol *> lz;
         m->symbolTable->LookupFunction(builtin::__count_trailing_zeros_uniform_i64, &lz);
-        llvm::Function *flz = lz[0]->function;
+        llvm::Function *flz = lz[0]->GetFunction();
         llvm::Value *elem_idx = CallInst(flz, nullptr, int_mask, llvm::Twine(mask->getName()) + "_clz");
         llvm::Value *elem = llvm::ExtractElementInst::Create(
             gather_result, elem_idx, llvm::Twine(gather_result->getName()) + "_umasked_elem", bblock);
@@ -9218,7 +9218,7 @@ const Type *FunctionSymbolExpr::GetTypeImpl() const {
 }
 
 llvm::Value *FunctionSymbolExpr::GetValue(FunctionEmitContext *ctx) const {
-    return matchingFunc ? matchingFunc->function : nullptr;
+    return matchingFunc ? matchingFunc->GetFunction() : nullptr;
 }
 
 Symbol *FunctionSymbolExpr::GetBaseSymbol() const { return matchingFunc; }
@@ -9298,7 +9298,7 @@ void lWarnDeprecatedFunction(Symbol *sym, SourcePos pos, const std::vector<const
 }
 
 std::pair<llvm::Constant *, bool> FunctionSymbolExpr::GetConstant(const Type *type) const {
-    if (matchingFunc == nullptr || matchingFunc->function == nullptr) {
+    if (matchingFunc == nullptr || matchingFunc->GetFunction() == nullptr) {
         return std::pair<llvm::Constant *, bool>(nullptr, false);
     }
 
@@ -9315,7 +9315,7 @@ std::pair<llvm::Constant *, bool> FunctionSymbolExpr::GetConstant(const Type *ty
         return std::pair<llvm::Constant *, bool>(nullptr, false);
     }
 
-    return std::pair<llvm::Constant *, bool>(matchingFunc->function, false);
+    return std::pair<llvm::Constant *, bool>(matchingFunc->GetFunction(), false);
 }
 
 static std::string lGetOverloadCandidateMessage(const std::vector<Symbol *> &funcs,
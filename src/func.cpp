@@ -51,7 +51,7 @@ using namespace ispc;
 bool Function::IsInternal() const {
     ispc::StorageClass sc = sym->storageClass;
     bool isInline = false;
-    llvm::Function *function = sym->function;
+    llvm::Function *function = sym->GetFunction();
     if (function != nullptr) {
         isInline = (function->getAttributes().getFnAttrs().hasAttribute(llvm::Attribute::AlwaysInline));
     }
@@ -59,7 +59,7 @@ bool Function::IsInternal() const {
 }
 
 void Function::UpdateLinkage(llvm::GlobalValue::LinkageTypes linkage) const {
-    llvm::Function *function = sym->function;
+    llvm::Function *function = sym->GetFunction();
     if (function != nullptr) {
         function->setLinkage(linkage);
     }
@@ -661,7 +661,7 @@ void Function::GenerateIR() const {
         return;
     }
 
-    llvm::Function *function = sym->function;
+    llvm::Function *function = sym->GetFunction();
     Assert(function != nullptr);
 
     // But if that function has a definition, we don't want to redefine it.
@@ -1059,6 +1059,9 @@ void FunctionTemplate::GenerateIR() const {
             if (!func->IsInternal()) {
                 func->UpdateLinkage(lGetTemplateInstantiationLinkage(inst.kind));
             }
+            if (llvm::Function *function = inst.symbol->GetFunction()) {
+                m->templateInstantiations.push_back(function->getName().str());
+            }
         } else {
             Error(inst.symbol->pos, "Template function specialization was declared but never defined.");
         }
@@ -9,6 +9,7 @@
            host stubs, dependency files.
 */
 
+#include "builtins-decl.h"
 #include "expr.h"
 #include "ispc.h"
 #include "module.h"
@@ -17,6 +18,8 @@
 #include "type.h"
 #include "util.h"
 
+#include <algorithm>
+#include <array>
 #include <ctype.h>
 #include <set>
 #include <sstream>
@@ -28,8 +31,11 @@
 
 #include <llvm/IR/DataLayout.h>
 #include <llvm/IR/DerivedTypes.h>
+#include <llvm/ADT/StringExtras.h>
 #include <llvm/Support/Casting.h>
+#include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Path.h>
+#include <llvm/Support/SHA256.h>
 
 using namespace ispc;
 
@@ -423,6 +429,22 @@ static void lPrintFunctionDeclarations(FILE *file, const std::vector<Symbol *> &
     }
 }
 
+// Returns the name of the temporary file used to write the given output
+// before it replaces the output with ReplaceFileIfDifferent(). The name is
+// unique, so concurrent compilations writing the same output don't clobber
+// each other's temporary files. Special files, e.g. /dev/stdout, are written
+// directly, and so is the output if the temporary file can't be created.
+static std::string lTemporaryFileName(const std::string &fileName) {
+    if (llvm::sys::fs::exists(fileName) && !llvm::sys::fs::is_regular_file(fileName)) {
+        return fileName;
+    }
+    llvm::SmallString<256> tmpPath;
+    if (llvm::sys::fs::createUniqueFile(fileName + "-%%%%%%.tmp", tmpPath)) {
+        return fileName;
+    }
+    return tmpPath.str().str();
+}
+
 static bool lIsExported(const Symbol *sym) {
     const FunctionType *ft = CastType<FunctionType>(sym->type);
     Assert(ft);
@@ -497,9 +519,6 @@ std::string Module::Output::DepsTargetName(const char *srcFile) const {
  * dispatcher requires different output settings.
  */
 bool Module::writeDeps(Output &CO) {
-    bool generateMakeRule = CO.flags.isMakeRuleDeps();
-    std::string targetName = CO.DepsTargetName(srcFile);
-
     reportInvalidSuffixWarning(CO.deps, OutputType::Deps);
 
     if (g->debugPrint) { // We may be passed nullptr for stdout output.
@@ -511,6 +530,13 @@ bool Module::writeDeps(Output &CO) {
         return false;
     }
 
+    printDeps(file, CO.DepsTargetName(srcFile), srcFile, registeredDependencies, CO.flags.isMakeRuleDeps());
+    fclose(file);
+    return true;
+}
+
+void Module::printDeps(FILE *file, const std::string &targetName, const char *srcFile,
+                       const std::set<std::string> &dependencies, bool generateMakeRule) {
     if (generateMakeRule) {
         fprintf(file, "%s:", targetName.c_str());
         // Rules always emit source first.
@@ -519,8 +545,7 @@ bool Module::writeDeps(Output &CO) {
         }
         std::string unescaped;
 
-        for (std::set<std::string>::const_iterator it = registeredDependencies.begin();
-             it != registeredDependencies.end(); ++it) {
+        for (std::set<std::string>::const_iterator it = dependencies.begin(); it != dependencies.end(); ++it) {
             unescaped = *it; // As this is preprocessor output, paths come escaped.
             lUnescapeStringInPlace(unescaped);
             if (srcFile && !IsStdin(srcFile) && 0 == strcmp(srcFile, unescaped.c_str())) {
@@ -532,13 +557,10 @@ bool Module::writeDeps(Output &CO) {
         }
         fprintf(file, "\n");
     } else {
-        for (std::set<std::string>::const_iterator it = registeredDependencies.begin();
-             it != registeredDependencies.end(); ++it) {
+        for (std::set<std::string>::const_iterator it = dependencies.begin(); it != dependencies.end(); ++it) {
             fprintf(file, "%s\n", it->c_str());
         }
     }
-    fclose(file);
-    return true;
 }
 
 std::string emitOffloadParamStruct(const std::string &paramStructName, const Symbol *sym, const FunctionType *fct) {
@@ -933,7 +955,11 @@ void Module::writeHeader(FILE *f) {
 }
 
 bool Module::writeHeader() {
-    FILE *f = fopen(output.header.c_str(), "w");
+    // The header is written to a temporary file first and replaces the
+    // existing one only if it is different, so that the code including it is
+    // not rebuilt when the exported interface doesn't change.
+    std::string tmpHeader = lTemporaryFileName(output.header);
+    FILE *f = fopen(tmpHeader.c_str(), "w");
 
     reportInvalidSuffixWarning(output.header, OutputType::Header);
 
@@ -948,9 +974,115 @@ bool Module::writeHeader() {
     writeHeader(f);
 
     fclose(f);
+    if (!ReplaceFileIfDifferent(tmpHeader, output.header)) {
+        Error(SourcePos(), "Cannot write header file \"%s\".", output.header.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Runs the given emitter on a temporary file and appends what it has written
+// to output. Returns false if the temporary file can't be created.
+template <typename F> static bool lCaptureOutput(F emit, std::string &output) {
+    FILE *f = tmpfile();
+    if (f == nullptr) {
+        return false;
+    }
+    emit(f);
+    rewind(f);
+    char buffer[4096];
+    size_t size = 0;
+    while ((size = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        output.append(buffer, size);
+    }
+    fclose(f);
+    return true;
+}
+
+// Returns a short hex digest of the text.
+static std::string lFingerprint(const std::string &text) {
+    llvm::ArrayRef<uint8_t> data(reinterpret_cast<const uint8_t *>(text.data()), text.size());
+    std::array<uint8_t, 32> hash = llvm::SHA256::hash(data);
+    return llvm::toHex(llvm::ArrayRef<uint8_t>(hash.data(), 16), /*LowerCase*/ true);
+}
+
+void Module::InterfaceFingerprint::add(const Module *module) {
+    std::vector<Symbol *> exportedFuncs;
+    module->symbolTable->GetMatchingFunctions(lIsExported, &exportedFuncs);
+    for (Symbol *sym : exportedFuncs) {
+        // A function changes when its declaration or any of the types
+        // it uses as parameters change.
+        std::vector<const StructType *> structTypes;
+        std::vector<const EnumType *> enumTypes;
+        std::vector<const VectorType *> vectorTypes;
+        lGetExportedParamTypes({sym}, &structTypes, &enumTypes, &vectorTypes);
+        m_complete &= lCaptureOutput(
+            [&](FILE *f) {
+                lPrintFunctionDeclarations(f, {sym}, false);
+                lEmitVectorTypedefs(vectorTypes, f);
+                lEmitEnumDecls(enumTypes, f);
+                lEmitStructDecls(structTypes, f);
+            },
+            m_functions[sym->name]);
+    }
+
+    for (const auto &exportedType : module->exportedTypes) {
+        const Type *type = exportedType.first->GetAsUniformType();
+        m_complete &= lCaptureOutput(
+            [type](FILE *f) {
+                if (const StructType *st = CastType<StructType>(type)) {
+                    std::vector<const StructType *> structTypes{st};
+                    lEmitStructDecls(structTypes, f);
+                } else if (const EnumType *et = CastType<EnumType>(type)) {
+                    lEmitEnumDecls({et}, f);
+                } else if (const VectorType *vt = CastType<VectorType>(type)) {
+                    lEmitVectorTypedefs({vt}, f);
+                }
+            },
+            m_types[type->GetString()]);
+    }
+}
+
+bool Module::InterfaceFingerprint::write(const std::string &fileName) const {
+    if (!m_complete) {
+        Error(SourcePos(), "Cannot create a temporary file for the interface fingerprint \"%s\".", fileName.c_str());
+        return false;
+    }
+
+    // Lines are "<kind> <fingerprint> <name>"; the first one covers the
+    // whole interface.
+    std::string lines;
+    for (const auto &function : m_functions) {
+        lines += "function " + lFingerprint(function.second) + " " + function.first + "\n";
+    }
+    for (const auto &type : m_types) {
+        lines += "type " + lFingerprint(type.second) + " " + type.first + "\n";
+    }
+
+    std::string tmpFileName = lTemporaryFileName(fileName);
+    FILE *f = fopen(tmpFileName.c_str(), "w");
+    if (!f) {
+        perror("fopen");
+        return false;
+    }
+    fprintf(f, "# Interface fingerprint generated by the ispc compiler.\n");
+    fprintf(f, "interface %s\n", lFingerprint(lines).c_str());
+    fputs(lines.c_str(), f);
+    fclose(f);
+
+    if (!ReplaceFileIfDifferent(tmpFileName, fileName)) {
+        Error(SourcePos(), "Cannot write interface fingerprint file \"%s\".", fileName.c_str());
+        return false;
+    }
     return true;
 }
 
+bool Module::writeInterfaceFingerprint() {
+    InterfaceFingerprint fingerprint;
+    fingerprint.add(this);
+    return fingerprint.write(output.fingerprint);
+}
+
 bool Module::DispatchHeaderInfo::initialize(std::string headerFileName) {
     EmitUnifs = true;
     EmitFuncs = true;
@@ -964,7 +1096,9 @@ bool Module::DispatchHeaderInfo::initialize(std::string headerFileName) {
     fn = header.c_str();
 
     if (!header.empty()) {
-        file = fopen(header.c_str(), "w");
+        // Written to a temporary file first, see closeFile().
+        tmpHeader = lTemporaryFileName(header);
+        file = fopen(tmpHeader.c_str(), "w");
         if (!file) {
             perror("fopen");
             return false;
@@ -977,7 +1111,46 @@ void Module::DispatchHeaderInfo::closeFile() {
     if (file != nullptr) {
         fclose(file);
         file = nullptr;
+        if (!Complete) {
+            if (tmpHeader != header) {
+                llvm::sys::fs::remove(tmpHeader);
+            }
+        } else if (!ReplaceFileIfDifferent(tmpHeader, header)) {
+            Error(SourcePos(), "Cannot write header file \"%s\".", header.c_str());
+        }
+    }
+}
+
+// Emits the declarations of the functions that limit the ISA used by the
+// dispatch functions. They are defined in the dispatch module of every
+// translation unit (see builtins/dispatch.c), so the guard prevents duplicate
+// declarations when the headers of several translation units are included.
+static void lEmitDispatchControlDecls(FILE *file) {
+    fprintf(file, "///////////////////////////////////////////////////////////////////////////\n");
+    fprintf(file, "// Control of the ISA used by the dispatch functions\n");
+    fprintf(file, "///////////////////////////////////////////////////////////////////////////\n");
+    fprintf(file, "#ifndef ISPC_DISPATCH_CONTROL_DEFINED\n#define ISPC_DISPATCH_CONTROL_DEFINED\n");
+    fprintf(file, "enum ISPCDispatchISA {\n");
+    for (int isa = dispatch::ISA::SSE2; isa < dispatch::ISA::COUNT; ++isa) {
+        // These ISAs are not supported as targets anymore.
+        if (isa == dispatch::ISA::AVX11 || isa == dispatch::ISA::KNL_AVX512) {
+            continue;
+        }
+        std::string name = llvm::StringRef(dispatch::isa_names[isa]).upper();
+        std::replace(name.begin(), name.end(), '.', '_');
+        fprintf(file, "    ISPC_DISPATCH_ISA_%s = %d,\n", name.c_str(), isa);
     }
+    fprintf(file, "};\n");
+    fprintf(file, "#if defined(__cplusplus) && (! defined(__ISPC_NO_EXTERN_C) || !__ISPC_NO_EXTERN_C )\nextern "
+                  "\"C\" {\n#endif // __cplusplus\n");
+    fprintf(file, "    // Limits the ISA used by the dispatch functions that haven't been called yet;\n");
+    fprintf(file, "    // a negative value removes the limit set before.\n");
+    fprintf(file, "    extern void %s(int32_t isa);\n", builtin::ISPCSetDispatchMaxISA);
+    fprintf(file, "    // Returns the most capable ISA the dispatch functions may use when called first.\n");
+    fprintf(file, "    extern int32_t %s();\n", builtin::ISPCGetDispatchISA);
+    fprintf(file, "#if defined(__cplusplus) && (! defined(__ISPC_NO_EXTERN_C) || !__ISPC_NO_EXTERN_C )\n} /* end "
+                  "extern C */\n#endif // __cplusplus\n");
+    fprintf(file, "#endif // ISPC_DISPATCH_CONTROL_DEFINED\n\n");
 }
 
 bool Module::writeDispatchHeader(DispatchHeaderInfo *DHI) {
@@ -1086,6 +1259,7 @@ bool Module::writeDispatchHeader(DispatchHeaderInfo *DHI) {
             lPrintFunctionDeclarations(f, exportedFuncs, 1, true);
             fprintf(f, "\n");
         }
+        lEmitDispatchControlDecls(f);
         DHI->EmitFuncs = false;
     }
 
@@ -1099,6 +1273,7 @@ bool Module::writeDispatchHeader(DispatchHeaderInfo *DHI) {
             fprintf(f, "\n#endif // %s\n", guard.c_str());
         }
         DHI->EmitBackMatter = false;
+        DHI->Complete = true;
     }
     return true;
 }
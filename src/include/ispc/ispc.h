@@ -5,8 +5,11 @@
 
 #pragma once
 
+#include <cstdint>
+#include <map>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace ispc {
@@ -48,6 +51,22 @@ int CompileFromArgs(const std::vector<std::string> &args);
  */
 int CompileFromCArgs(int argc, char *argv[]);
 
+/**
+ * @brief Value of a uniform parameter for ISPCEngine::GetSpecializedJitFunction().
+ * Integer and bool parameters take the integer value, floating-point parameters
+ * take the floating-point one.
+ */
+struct JitParamValue {
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+    JitParamValue(T value)
+        : isFloat(std::is_floating_point<T>::value), intValue(static_cast<int64_t>(value)),
+          floatValue(static_cast<double>(value)) {}
+
+    bool isFloat;
+    int64_t intValue;
+    double floatValue;
+};
+
 class ISPCEngine {
   public:
     /**
@@ -80,6 +99,32 @@ class ISPCEngine {
      */
     int CompileFromFileToJit(const std::string &filename);
 
+    /**
+     * @brief Compiles ISPC code from a memory buffer using JIT compilation.
+     * @param source ISPC source code.
+     * @param filename Name of the source file used in diagnostics and to resolve
+     *                 relative includes. The file doesn't need to exist.
+     * @param includes Files that the source may include, mapping file name to file
+     *                 content. They take precedence over the files on disk.
+     * @return 0 on success, non-zero on failure.
+     */
+    int CompileFromSourceToJit(const std::string &source, const std::string &filename,
+                               const std::map<std::string, std::string> &includes = {});
+
+    /**
+     * @brief Compiles ISPC code from a memory buffer to an object file in memory.
+     * Only single target compilation is supported.
+     * @param source ISPC source code.
+     * @param filename Name of the source file used in diagnostics and to resolve
+     *                 relative includes. The file doesn't need to exist.
+     * @param object Receives the content of the object file.
+     * @param includes Files that the source may include, mapping file name to file
+     *                 content. They take precedence over the files on disk.
+     * @return 0 on success, non-zero on failure.
+     */
+    int CompileFromSourceToObject(const std::string &source, const std::string &filename, std::vector<char> &object,
+                                  const std::map<std::string, std::string> &includes = {});
+
     /**
      * @brief Retrieves a function pointer from JIT-compiled code.
      * @param functionName Name of the exported function.
@@ -87,6 +132,32 @@ class ISPCEngine {
      */
     void *GetJitFunction(const std::string &functionName);
 
+    /**
+     * @brief Retrieves a version of a JIT-compiled function specialized for the given
+     * values of some of its parameters.
+     * The function is compiled again with the values folded in as constants, so loops
+     * with known trip counts can be unrolled and branches on the values removed.
+     * Specializations are cached, so later calls with the same values return the same
+     * pointer. The specialized function has the signature of the original one, the
+     * arguments passed for the specialized parameters are ignored.
+     * Requires SetJitSpecialization(true) before the first JIT compilation.
+     * @param functionName Name of the exported function.
+     * @param params Values of the parameters to specialize, mapping the parameter index
+     *               to its value. Only integer, bool and floating-point parameters can
+     *               be specialized.
+     * @return Function pointer or nullptr on failure.
+     */
+    void *GetSpecializedJitFunction(const std::string &functionName, const std::map<unsigned, JitParamValue> &params);
+
+    /**
+     * @brief Returns the target used for JIT compilation.
+     * Unless a target is given in the arguments of the engine, it is the best target
+     * that both the host CPU and the library support, detected when the engine is created.
+     * @return Target name, e.g. "avx512spr-x16", or an empty string if the target is
+     *         derived from the --cpu argument or there are several targets.
+     */
+    std::string GetJitTarget() const;
+
     /**
      * @brief Sets a user-provided runtime function for JIT compilation.
      * Runtime functions must be provided before calling CompileFromFileToJit().
@@ -96,6 +167,26 @@ class ISPCEngine {
      */
     bool SetJitRuntimeFunction(const std::string &functionName, void *functionPtr);
 
+    /**
+     * @brief Enables or disables lazy JIT compilation.
+     * In lazy mode, exported functions are stubs that generate the code of a function on
+     * its first call, so the cost of CompileFromFileToJit() doesn't depend on the number of
+     * functions in the source. Must be called before the first JIT compilation.
+     * @param enable true to compile functions on first call, false to compile them upfront
+     * @return true on success, false if JIT code was already compiled
+     */
+    bool SetJitLazyCompilation(bool enable);
+
+    /**
+     * @brief Enables or disables GetSpecializedJitFunction().
+     * Specialization compiles functions again from the bitcode of the modules, so the
+     * engine keeps a copy of the bitcode of every JIT-compiled module when it is enabled.
+     * Must be called before the first JIT compilation.
+     * @param enable true to allow specialization, false to not keep the bitcode
+     * @return true on success, false if JIT code was already compiled
+     */
+    bool SetJitSpecialization(bool enable);
+
     /**
      * @brief Clears a specific runtime function.
      * @param functionName Name of the function to clear
@@ -42,6 +42,14 @@ enum ISA {
 #define UNUSED_ATTR
 #endif
 
+// Names of the ISAs indexed with the ISA enumerants. They are the ISA parts of
+// the target names and are accepted by the ISPC_DISPATCH_MAX_ISA environment
+// variable that limits the ISA used by the dispatch functions.
+UNUSED_ATTR static const char *const isa_names[COUNT] = {
+    "sse2", "sse4.1",    "sse4.2",    "avx1",      "avx1.1",    "avx2",      "avx2vnni",
+    "knl",  "avx512skx", "avx512icl", "avx512spr", "avx512gnr", "avx10.2dmr",
+};
+
 #ifndef MACOS
 // MACOS macro can be defined when we are compiling dispatch.c for macOS.
 // In other cases, we need to define it manually if we are compiling for macOS.
@@ -9,6 +9,7 @@
 */
 
 #include "ispc.h"
+#include "bitcode_lib.h"
 #include "llvmutil.h"
 #include "module.h"
 #include "util.h"
@@ -221,15 +222,10 @@ static ISPCTarget lGetARMSystemISA() {
 #endif
 #endif // defined(ISPC_HOST_IS_ARM) || defined(ISPC_HOST_IS_AARCH64)
 
-static ISPCTarget lGetSystemISA() {
-#if defined(ISPC_HOST_IS_ARM) || defined(ISPC_HOST_IS_AARCH64)
-    return lGetARMSystemISA();
-#elif defined(ISPC_HOST_IS_RISCV)
-    return ISPCTarget::rvv_x4;
-#elif defined(ISPC_HOST_IS_PPC64LE)
-    return ISPCTarget::generic_i32x4;
-#elif defined(ISPC_HOST_IS_X86)
-    enum Target::ISA isa = (enum Target::ISA)dispatch::get_x86_isa();
+#if defined(ISPC_HOST_IS_X86)
+// Returns the target for the given x86 ISA or ISPCTarget::none if the ISA is
+// not supported.
+static ISPCTarget lGetX86TargetForISA(Target::ISA isa) {
     switch (isa) {
     case Target::ISA::SSE2:
         return ISPCTarget::sse2_i32x4;
@@ -246,9 +242,6 @@ static ISPCTarget lGetSystemISA() {
         return ISPCTarget::avx2_i32x8;
     case Target::ISA::AVX2VNNI:
         return ISPCTarget::avx2vnni_i32x8;
-    case Target::ISA::KNL_AVX512:
-        Error(SourcePos(), "Detected unsupported KNL ISA. Exiting.");
-        exit(1);
     case Target::ISA::SKX_AVX512:
         return ISPCTarget::avx512skx_x16;
     case Target::ISA::ICL_AVX512:
@@ -265,10 +258,30 @@ static ISPCTarget lGetSystemISA() {
         return ISPCTarget::avx512gnr_x16;
 #endif
     default:
-        Error(SourcePos(), "Detected unsupported x86 ISA. Exiting.");
+        return ISPCTarget::none;
+    }
+}
+#endif
+
+static ISPCTarget lGetSystemISA() {
+#if defined(ISPC_HOST_IS_ARM) || defined(ISPC_HOST_IS_AARCH64)
+    return lGetARMSystemISA();
+#elif defined(ISPC_HOST_IS_RISCV)
+    return ISPCTarget::rvv_x4;
+#elif defined(ISPC_HOST_IS_PPC64LE)
+    return ISPCTarget::generic_i32x4;
+#elif defined(ISPC_HOST_IS_X86)
+    enum Target::ISA isa = (enum Target::ISA)dispatch::get_x86_isa();
+    ISPCTarget target = lGetX86TargetForISA(isa);
+    if (target == ISPCTarget::none) {
+        if (isa == Target::ISA::KNL_AVX512) {
+            Error(SourcePos(), "Detected unsupported KNL ISA. Exiting.");
+        } else {
+            Error(SourcePos(), "Detected unsupported x86 ISA. Exiting.");
+        }
         exit(1);
     }
-    return ISPCTarget::none;
+    return target;
 #else
 #error "Unsupported host CPU architecture."
 #endif
@@ -2415,6 +2428,52 @@ std::unique_ptr<Target> Target::Create(Arch arch, const char *cpu, ISPCTarget ta
     return ptr;
 }
 
+// Returns the next less capable target that runs on the CPUs that support the
+// given target, or ISPCTarget::none if there is none.
+static ISPCTarget lGetHostTargetFallback(ISPCTarget target) {
+    switch (target) {
+    case ISPCTarget::avx10_2dmr_x16:
+        return ISPCTarget::avx512gnr_x16;
+    case ISPCTarget::avx512gnr_x16:
+        return ISPCTarget::avx512spr_x16;
+    case ISPCTarget::avx512spr_x16:
+        return ISPCTarget::avx512icl_x16;
+    case ISPCTarget::avx512icl_x16:
+        return ISPCTarget::avx512skx_x16;
+    case ISPCTarget::avx512skx_x16:
+    case ISPCTarget::avx2vnni_i32x8:
+        return ISPCTarget::avx2_i32x8;
+    case ISPCTarget::avx2_i32x8:
+        return ISPCTarget::avx1_i32x8;
+    case ISPCTarget::avx1_i32x8:
+        return ISPCTarget::sse4_i32x4;
+    case ISPCTarget::sse4_i32x4:
+        return ISPCTarget::sse41_i32x4;
+    case ISPCTarget::sse41_i32x4:
+        return ISPCTarget::sse2_i32x4;
+    default:
+        return ISPCTarget::none;
+    }
+}
+
+ISPCTarget Target::GetHostTarget() {
+    // Start from the target that --target=host would select and, unlike
+    // lGetSystemISA(), fall back to less capable targets when this build
+    // doesn't support it instead of exiting.
+#if defined(ISPC_HOST_IS_X86)
+    ISPCTarget target = lGetX86TargetForISA((ISA)dispatch::get_x86_isa());
+#else
+    ISPCTarget target = lGetSystemISA();
+#endif
+    for (; target != ISPCTarget::none; target = lGetHostTargetFallback(target)) {
+        Arch arch = lGetArchFromTarget(target, CPU_None);
+        if (g->target_registry->isSupported(target, g->target_os, arch)) {
+            return target;
+        }
+    }
+    return ISPCTarget::none;
+}
+
 bool Target::checkIntrinsticSupport(llvm::StringRef name, SourcePos pos) {
     if (name.consume_front("llvm.") == false) {
         return false;
@@ -3169,6 +3228,8 @@ Opt::Opt() {
     disableGatherScatterFlattening = false;
     disableUniformMemoryOptimizations = false;
     disableCoalescing = false;
+    disableGatherScatterVersioning = false;
+    disableUniformArgSpecialization = false;
     disableZMM = false;
     resetFTZ_DAZ = false;
 #ifdef ISPC_XE_ENABLED
@@ -3187,11 +3248,13 @@ Globals::Globals() {
     target_registry = TargetLibRegistry::getTargetLibRegistry();
 
     mathLib = Globals::MathLib::Math_ISPC;
+    dispatchMode = Globals::DispatchMode::Pointer;
     codegenOptLevel = Globals::CodegenOptLevel::Aggressive;
 
     includeStdlib = true;
     runCPP = true;
     onlyCPP = false;
+    scanDeps = false;
     functionSections = false;
     ignoreCPPErrors = false;
     debugPrint = false;
@@ -3230,8 +3293,14 @@ Globals::Globals() {
     disableTargetValidation = false;
     // set default granularity to 500.
     timeTraceGranularity = 500;
+    numJobs = 1;
+    optimizeLinkedModule = false;
+    // 5 GB by default, same as ccache.
+    cacheMaxSize = 5ull * 1024 * 1024 * 1024;
     target = nullptr;
     ctx = new llvm::LLVMContext;
+    bitcodeLibCache = nullptr;
+    compileReport = nullptr;
     SSPLevel = SSPKind::SSPNone;
 
 #ifdef ISPC_XE_ENABLED
@@ -3257,6 +3326,9 @@ Globals::Globals() {
 }
 
 Globals::~Globals() {
+    // Cached modules belong to ctx, so they have to be destroyed first.
+    delete bitcodeLibCache;
+    bitcodeLibCache = nullptr;
     if (ctx) {
         delete ctx;
         ctx = nullptr;
@@ -83,6 +83,8 @@ class ArrayType;
 class AST;
 class ASTNode;
 class AtomicType;
+class BitcodeLibCache;
+class CompileReport;
 class FunctionEmitContext;
 class Expr;
 class ExprList;
@@ -319,6 +321,10 @@ class Target {
         target. */
     llvm::TargetMachine *GetTargetMachine() const { return m_targetMachine; }
 
+    /** Returns the best target that both the host CPU and this build of
+        ISPC support, or ISPCTarget::none if there is no such target. */
+    static ISPCTarget GetHostTarget();
+
     /** Convert ISA enum to string */
     static const char *ISAToString(Target::ISA isa);
 
@@ -651,6 +657,15 @@ struct Opt {
         access from gathers into wider vector operations, when possible. */
     bool disableCoalescing;
 
+    /** Disables the optimization that checks at run time whether the
+        offsets of gathers and scatters in loops are contiguous, and uses
+        vector loads and stores if so. */
+    bool disableGatherScatterVersioning;
+
+    /** Disables cloning functions that aren't inlined for the calls that
+        pass uniform values to their varying parameters. */
+    bool disableUniformArgSpecialization;
+
     /** Disable using zmm registers for avx512 target in favour of ymm.
         Affects only >= 512 bit wide targets and only if avx512vl is available */
     bool disableZMM;
@@ -720,6 +735,12 @@ struct Globals {
     enum class MathLib { Math_ISPC, Math_ISPCFast, Math_SVML, Math_System };
     MathLib mathLib;
 
+    /** How the dispatch functions of multi-target compilation select the
+        variant to call: on the first call, caching the function pointer,
+        or once at load time through a GNU indirect function. */
+    enum class DispatchMode { Pointer, IFunc };
+    DispatchMode dispatchMode;
+
     /** Optimization level to be specified while creating TargetMachine. */
     enum class CodegenOptLevel { None, Default, Aggressive };
     CodegenOptLevel codegenOptLevel;
@@ -739,6 +760,13 @@ struct Globals {
     /** When \c true, only runs the C pre-processor. (Default is false.) */
     bool onlyCPP;
 
+    /** When \c true, only the dependencies of the source files are written,
+        see --scan-deps. (Default is false.) */
+    bool scanDeps;
+
+    /** Source files whose dependencies are written with --scan-deps. */
+    std::vector<std::string> scanDepsFiles;
+
     /** When \c true, suppresses errors from the C pre-processor.
         (Default is false.) */
     bool ignoreCPPErrors;
@@ -880,6 +908,11 @@ struct Globals {
     /** Global LLVMContext object */
     llvm::LLVMContext *ctx;
 
+    /** Parsed bitcode libraries that are reused by the compilations
+        sharing this context, or nullptr if the libraries are parsed anew
+        for every compilation. It is owned by Globals. */
+    BitcodeLibCache *bitcodeLibCache;
+
     /** Current working directory when the ispc compiler starts
         execution. */
     char currentDirectory[1024];
@@ -924,6 +957,42 @@ struct Globals {
     /* When compile time tracing is enabled, set time granularity. */
     int timeTraceGranularity;
 
+    /* Number of threads used for code generation: one target module per
+       thread when compiling for multiple targets, or one partition of the
+       module per thread for a single target. */
+    int numJobs;
+
+    /* When true, "ispc link" runs the optimization pipeline over the linked
+       module (set by -O<n> in link mode). */
+    bool optimizeLinkedModule;
+
+    /* Directory of the persistent compilation cache. Empty string disables
+       the cache. */
+    std::string cacheDir;
+
+    /* Maximum size of the compilation cache in bytes. */
+    uint64_t cacheMaxSize;
+
+    /* File for the per-phase compile time and memory report in JSON format
+       (see --compile-report). Empty string disables the report. */
+    std::string compileReportFile;
+
+    /* Report collected during the current compilation, nullptr if no report
+       is requested. */
+    CompileReport *compileReport;
+
+    /* Directory of the cache of optimized template instantiations shared
+       between compilations (see --template-cache-dir). Empty string disables
+       the cache. */
+    std::string templateCacheDir;
+
+    /* Manifest of compile jobs to run in one process (see --batch). Empty
+       string means a regular compilation. */
+    std::string batchManifest;
+
+    /* Command-line arguments that are part of the compilation cache key. */
+    std::vector<std::string> cacheKeyArgs;
+
     /* Set macOS/iOS deployment target. The version will be propagated to the triple.
        This address the new linker introduced in Xcode 15 that issues a warning if version when no version is provided.
        https://github.com/ispc/ispc/issues/3143  */
@@ -15,7 +15,11 @@
 
 // ISPC headers
 #include "args.h"
+#include "batch.h"
 #include "binary_type.h"
+#include "bitcode_lib.h"
+#include "compile_cache.h"
+#include "compile_report.h"
 #include "ispc.h"
 #include "ispc/ispc.h"
 #include "target_registry.h"
@@ -43,6 +47,12 @@
 #include <llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h>
 #include <llvm/ExecutionEngine/Orc/Shared/ExecutorAddress.h>
 #include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Transforms/Utils/Cloning.h>
 #endif
 
 // Standard C++ headers
@@ -133,6 +143,127 @@ class GlobalStateGuard {
     Target *savedTarget;
 };
 
+#ifdef ISPC_JIT_ON
+// Key of a specialization in the cache of the engine: the function name
+// followed by the index and the value of every specialized parameter.
+static std::string lSpecializationKey(const std::string &functionName,
+                                      const std::map<unsigned, JitParamValue> &params) {
+    std::string key = functionName;
+    for (const auto &[index, value] : params) {
+        key += "," + std::to_string(index) + "=";
+        if (value.isFloat) {
+            uint64_t bits;
+            std::memcpy(&bits, &value.floatValue, sizeof(bits));
+            key += "f" + std::to_string(bits);
+        } else {
+            key += "i" + std::to_string(value.intValue);
+        }
+    }
+    return key;
+}
+
+/** Creates a module that defines specializedName, a copy of the function
+    functionName from the bitcode of a JIT-compiled module with the given
+    parameters replaced by constants. The rest of the module is either copied
+    with internal linkage (functions and constants) or refers to the
+    definitions that are already in the JIT (global variables). Returns
+    nullptr on failure. */
+static std::unique_ptr<llvm::Module> lCreateSpecializedModule(llvm::LLVMContext &context, const std::string &bitcode,
+                                                              const std::string &functionName,
+                                                              const std::string &specializedName,
+                                                              const std::map<unsigned, JitParamValue> &params) {
+    auto moduleOrError = llvm::parseBitcodeFile(llvm::MemoryBufferRef(bitcode, functionName), context);
+    if (!moduleOrError) {
+        Error(SourcePos(), "Failed to read JIT module: %s", llvm::toString(moduleOrError.takeError()).c_str());
+        return nullptr;
+    }
+    std::unique_ptr<llvm::Module> module = std::move(*moduleOrError);
+    llvm::Function *func = module->getFunction(functionName);
+    Assert(func != nullptr && !func->isDeclaration());
+
+    // The function itself may be called from the other functions of the
+    // module, so specialize a copy of it.
+    llvm::ValueToValueMapTy VMap;
+    llvm::Function *specialized = llvm::CloneFunction(func, VMap);
+    specialized->setName(specializedName);
+    specialized->setLinkage(llvm::GlobalValue::ExternalLinkage);
+
+    for (const auto &[index, value] : params) {
+        if (index >= specialized->arg_size()) {
+            Error(SourcePos(), "Function '%s' has no parameter %u.", functionName.c_str(), index);
+            return nullptr;
+        }
+        llvm::Argument *arg = specialized->getArg(index);
+        llvm::Type *type = arg->getType();
+        llvm::Constant *constant = nullptr;
+        if (type->isIntegerTy() && !value.isFloat) {
+            constant = llvm::ConstantInt::get(type, value.intValue, true);
+        } else if (type->isFloatingPointTy()) {
+            constant = llvm::ConstantFP::get(type, value.isFloat ? value.floatValue : (double)value.intValue);
+        } else {
+            Error(SourcePos(), "Parameter %u of function '%s' can't be specialized with a %s value.", index,
+                  functionName.c_str(), value.isFloat ? "floating-point" : "integer");
+            return nullptr;
+        }
+        arg->replaceAllUsesWith(constant);
+    }
+
+    for (llvm::Function &F : *module) {
+        if (&F != specialized && !F.isDeclaration()) {
+            F.setLinkage(llvm::GlobalValue::InternalLinkage);
+            F.setComdat(nullptr);
+        }
+    }
+    for (llvm::GlobalVariable &GV : module->globals()) {
+        if (GV.isDeclaration() || GV.hasAppendingLinkage() || GV.hasLocalLinkage()) {
+            continue;
+        }
+        GV.setComdat(nullptr);
+        if (GV.isConstant()) {
+            GV.setLinkage(llvm::GlobalValue::InternalLinkage);
+        } else {
+            GV.setInitializer(nullptr);
+            GV.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        }
+    }
+
+    // Fold the constants and drop everything the specialized function doesn't use.
+    auto targetMachine = llvm::orc::JITTargetMachineBuilder::detectHost();
+    std::unique_ptr<llvm::TargetMachine> TM;
+    if (targetMachine) {
+        if (auto TMOrError = targetMachine->createTargetMachine()) {
+            TM = std::move(*TMOrError);
+        } else {
+            llvm::consumeError(TMOrError.takeError());
+        }
+    } else {
+        llvm::consumeError(targetMachine.takeError());
+    }
+    llvm::LoopAnalysisManager LAM;
+    llvm::FunctionAnalysisManager FAM;
+    llvm::CGSCCAnalysisManager CGAM;
+    llvm::ModuleAnalysisManager MAM;
+    llvm::PassBuilder PB(TM.get());
+    PB.registerModuleAnalyses(MAM);
+    PB.registerCGSCCAnalyses(CGAM);
+    PB.registerFunctionAnalyses(FAM);
+    PB.registerLoopAnalyses(LAM);
+    PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+    llvm::ModulePassManager MPM = PB.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O3);
+    MPM.run(*module, MAM);
+
+    // Variables with internal linkage can't be shared with the original module.
+    for (llvm::GlobalVariable &GV : module->globals()) {
+        if (GV.hasLocalLinkage() && !GV.isConstant()) {
+            Error(SourcePos(), "Function '%s' can't be specialized: it uses the static variable '%s'.",
+                  functionName.c_str(), GV.getName().str().c_str());
+            return nullptr;
+        }
+    }
+    return module;
+}
+#endif
+
 /**
  * @brief Implementation class for ISPCEngine
  *
@@ -164,11 +295,25 @@ class ISPCEngine::Impl {
 #ifdef ISPC_JIT_ON
     // JIT-related fields
     bool m_isJitMode{false};
+    bool m_isLazyJit{false};
+    bool m_isJitSpecialization{false};
+
+    // Target for JIT compilation, detected from the host CPU at engine
+    // creation unless the target is given in the arguments
+    ISPCTarget m_jitTarget{ISPCTarget::none};
     std::unique_ptr<llvm::orc::LLJIT> m_jit;
 
     // User-provided runtime functions storage
     // Maps function name to function pointer for runtime functions
     std::map<std::string, void *> m_runtimeFunctions;
+
+    // Bitcode of the modules added to the JIT, kept only when specialization
+    // is enabled, and the index of the module that defines every external function
+    std::vector<std::string> m_jitBitcode;
+    std::map<std::string, size_t> m_jitFunctionModules;
+
+    // Specialized functions, see lSpecializationKey() for the key format
+    std::map<std::string, void *> m_specializedFunctions;
 #endif
 
     bool IsLinkMode() const { return m_isLinkMode; }
@@ -188,8 +333,33 @@ class ISPCEngine::Impl {
         int ret = 0;
         {
             llvm::TimeTraceScope TimeScope("ExecuteISPCEngine");
-            ret = Module::CompileAndOutput(m_file.c_str(), m_arch, m_cpu.empty() ? nullptr : m_cpu.c_str(), m_targets,
-                                           m_output);
+            const char *cpu = m_cpu.empty() ? nullptr : m_cpu.c_str();
+            CompilationCache cache(g->cacheDir);
+            bool cacheable = !g->cacheDir.empty() && cache.Prepare(m_file.c_str(), m_arch, cpu, m_targets, m_output);
+            if (cacheable && cache.Lookup()) {
+                return 0;
+            }
+
+            CompileReport report;
+            auto start = std::chrono::steady_clock::now();
+            if (!g->compileReportFile.empty()) {
+                g->compileReport = &report;
+            }
+
+            ret = Module::CompileAndOutput(m_file.c_str(), m_arch, cpu, m_targets, m_output);
+
+            g->compileReport = nullptr;
+            if (!g->compileReportFile.empty() && ret == 0) {
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                if (!report.Write(g->compileReportFile, m_file, seconds)) {
+                    Error(SourcePos(), "Cannot write compile report to \"%s\".", g->compileReportFile.c_str());
+                    ret = 1;
+                }
+            }
+
+            if (cacheable && ret == 0) {
+                cache.Store();
+            }
         }
 
         if (g->enableTimeTrace) {
@@ -203,18 +373,45 @@ class ISPCEngine::Impl {
     }
 
     int Link() {
-        std::string filename = !m_output.out.empty() ? m_output.out : "";
-        return Module::LinkAndOutput(m_linkFileNames, m_output.type, std::move(filename));
+        const char *cpu = m_cpu.empty() ? nullptr : m_cpu.c_str();
+        return Module::LinkAndOutput(m_linkFileNames, m_arch, cpu, m_targets, m_output);
+    }
+
+    int ScanDeps() {
+        // m_file is the first of the files; this reports a missing input.
+        if (!ValidateInput(m_file)) {
+            return 1;
+        }
+        for (const std::string &file : g->scanDepsFiles) {
+            if (!ValidateInput(file)) {
+                return 1;
+            }
+        }
+        const char *cpu = m_cpu.empty() ? nullptr : m_cpu.c_str();
+        return Module::ScanDependencies(g->scanDepsFiles, m_arch, cpu, m_targets, m_output) == 0 ? 0 : 1;
+    }
+
+    int Batch() {
+#ifdef ISPC_IS_LIBRARY
+        Error(SourcePos(), "The --batch option is only supported by the ispc executable.");
+        return 1;
+#else
+        return CompileBatch(g->batchManifest, g->numJobs) == 0 ? 0 : 1;
+#endif
     }
 
     int Execute() {
         // TODO!: remove the global state.
         GlobalStateGuard guard; // The guard to protect global state
 
-        if (m_isLinkMode) {
+        if (!g->batchManifest.empty()) {
+            return Batch();
+        } else if (m_isLinkMode) {
             return Link();
         } else if (m_isHelpMode) {
             return 0;
+        } else if (g->scanDeps) {
+            return ScanDeps();
         } else {
             return Compile();
         }
@@ -225,43 +422,46 @@ class ISPCEngine::Impl {
         if (!ValidateInput(filename, false)) { // Don't allow stdin for JIT
             return 1;
         }
+        return CompileToJit(filename, nullptr);
+    }
 
-        // JIT compilation only supports single target compilation
-        if (m_targets.size() > 1) {
-            Error(SourcePos(), "JIT compilation only supports single target compilation.");
+    int CompileFromSourceToJit(const std::string &source, const std::string &filename,
+                               const std::map<std::string, std::string> &includes) {
+        Module::VirtualFiles files;
+        if (!CreateVirtualFiles(source, filename, includes, files)) {
             return 1;
         }
+        return CompileToJit(filename, &files);
+    }
+#else
+    int CompileFromFileToJit(const std::string &filename) {
+        Error(SourcePos(), "JIT compilation is not supported in this build");
+        return 1;
+    }
 
-        // Initialize JIT if needed
-        if (!InitializeJit()) {
-            return 1;
-        }
+    int CompileFromSourceToJit(const std::string &source, const std::string &filename,
+                               const std::map<std::string, std::string> &includes) {
+        Error(SourcePos(), "JIT compilation is not supported in this build");
+        return 1;
+    }
+#endif
 
-        // Compile ISPC file to LLVM module
-        auto llvmModule =
-            Module::CompileToLLVMModule(filename.c_str(), m_arch, m_cpu.empty() ? nullptr : m_cpu.c_str(), m_targets);
-        if (!llvmModule) {
+    int CompileFromSourceToObject(const std::string &source, const std::string &filename,
+                                  const std::map<std::string, std::string> &includes, std::vector<char> &object) {
+        Module::VirtualFiles files;
+        if (!CreateVirtualFiles(source, filename, includes, files)) {
             return 1;
         }
 
-        // Create a fresh context for this module
-        auto context = std::make_unique<llvm::LLVMContext>();
-        auto tsm = llvm::orc::ThreadSafeModule(std::move(llvmModule), llvm::orc::ThreadSafeContext(std::move(context)));
-
-        auto addResult = m_jit->addIRModule(std::move(tsm));
-        if (addResult) {
-            Error(SourcePos(), "Failed to add module to JIT: %s", llvm::toString(std::move(addResult)).c_str());
+        if (m_targets.size() > 1) {
+            Error(SourcePos(), "In-memory compilation only supports single target compilation.");
             return 1;
         }
 
-        return 0;
+        EnableBitcodeLibCache();
+        return Module::CompileToObjectBuffer(filename.c_str(), m_arch, m_cpu.empty() ? nullptr : m_cpu.c_str(),
+                                             m_targets, &files, object);
     }
-#else
-    int CompileFromFileToJit(const std::string &filename) {
-        Error(SourcePos(), "JIT compilation is not supported in this build");
-        return 1;
-    }
-#endif
 
 #ifdef ISPC_JIT_ON
     void *GetJitFunction(const std::string &functionName) {
@@ -300,6 +500,60 @@ class ISPCEngine::Impl {
     }
 #endif
 
+#ifdef ISPC_JIT_ON
+    void *GetSpecializedJitFunction(const std::string &functionName,
+                                    const std::map<unsigned, JitParamValue> &params) {
+        if (params.empty()) {
+            return GetJitFunction(functionName);
+        }
+
+        if (!m_isJitMode) {
+            Error(SourcePos(), "JIT mode is not active.");
+            return nullptr;
+        }
+
+        if (!m_isJitSpecialization) {
+            Error(SourcePos(), "JIT specialization is not enabled, call SetJitSpecialization(true) before the first "
+                               "JIT compilation.");
+            return nullptr;
+        }
+
+        std::string key = lSpecializationKey(functionName, params);
+        auto it = m_specializedFunctions.find(key);
+        if (it != m_specializedFunctions.end()) {
+            return it->second;
+        }
+
+        auto source = m_jitFunctionModules.find(functionName);
+        if (source == m_jitFunctionModules.end()) {
+            Error(SourcePos(), "Function '%s' not found in JIT.", functionName.c_str());
+            return nullptr;
+        }
+
+        // The specialization is compiled in its own context, so it doesn't
+        // depend on the global state of the compiler.
+        auto context = std::make_unique<llvm::LLVMContext>();
+        std::string specializedName = functionName + "___spec" + std::to_string(m_specializedFunctions.size());
+        auto llvmModule =
+            lCreateSpecializedModule(*context, m_jitBitcode[source->second], functionName, specializedName, params);
+        if (!llvmModule || !AddModuleToJit(std::move(llvmModule), std::move(context))) {
+            return nullptr;
+        }
+
+        void *ptr = GetJitFunction(specializedName);
+        if (ptr) {
+            m_specializedFunctions[key] = ptr;
+        }
+        return ptr;
+    }
+#else
+    void *GetSpecializedJitFunction(const std::string &functionName,
+                                    const std::map<unsigned, JitParamValue> &params) {
+        Error(SourcePos(), "JIT compilation is not supported in this build");
+        return nullptr;
+    }
+#endif
+
 #ifdef ISPC_JIT_ON
     void ClearJitCode() {
         if (m_isJitMode && m_jit) {
@@ -318,6 +572,9 @@ class ISPCEngine::Impl {
 
             // Reset the JIT engine - this should not throw in normal circumstances
             m_jit.reset();
+            m_jitBitcode.clear();
+            m_jitFunctionModules.clear();
+            m_specializedFunctions.clear();
         }
     }
 #else
@@ -354,6 +611,38 @@ class ISPCEngine::Impl {
     }
 #endif
 
+#ifdef ISPC_JIT_ON
+    bool SetJitLazyCompilation(bool enable) {
+        if (m_isJitMode) {
+            Error(SourcePos(), "Lazy JIT compilation must be configured before the first JIT compilation.");
+            return false;
+        }
+        m_isLazyJit = enable;
+        return true;
+    }
+#else
+    bool SetJitLazyCompilation(bool enable) {
+        Error(SourcePos(), "JIT compilation is not supported in this build");
+        return false;
+    }
+#endif
+
+#ifdef ISPC_JIT_ON
+    bool SetJitSpecialization(bool enable) {
+        if (m_isJitMode) {
+            Error(SourcePos(), "JIT specialization must be configured before the first JIT compilation.");
+            return false;
+        }
+        m_isJitSpecialization = enable;
+        return true;
+    }
+#else
+    bool SetJitSpecialization(bool enable) {
+        Error(SourcePos(), "JIT compilation is not supported in this build");
+        return false;
+    }
+#endif
+
 #ifdef ISPC_JIT_ON
     void ClearJitRuntimeFunction(const std::string &functionName) {
         // Clear specific function
@@ -399,17 +688,24 @@ class ISPCEngine::Impl {
             return true;
         }
 
-        // Create LLJIT instance - it will manage its own context
-        auto jitBuilder = llvm::orc::LLJITBuilder();
-        auto jitOrError = jitBuilder.create();
-
-        if (!jitOrError) {
-            Error(SourcePos(), "Failed to create JIT engine: %s", llvm::toString(jitOrError.takeError()).c_str());
-            return false;
+        // Create LLJIT instance - it will manage its own context. In lazy mode
+        // every function is compiled on its first call through a stub.
+        if (m_isLazyJit) {
+            auto jitOrError = llvm::orc::LLLazyJITBuilder().create();
+            if (!jitOrError) {
+                Error(SourcePos(), "Failed to create JIT engine: %s", llvm::toString(jitOrError.takeError()).c_str());
+                return false;
+            }
+            m_jit = std::move(*jitOrError);
+        } else {
+            auto jitOrError = llvm::orc::LLJITBuilder().create();
+            if (!jitOrError) {
+                Error(SourcePos(), "Failed to create JIT engine: %s", llvm::toString(jitOrError.takeError()).c_str());
+                return false;
+            }
+            m_jit = std::move(*jitOrError);
         }
 
-        m_jit = std::move(*jitOrError);
-
         // Add process symbols generator to find runtime functions from the current process
         auto processSymbolsGenerator =
             llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(m_jit->getDataLayout().getGlobalPrefix());
@@ -449,7 +745,137 @@ class ISPCEngine::Impl {
     }
 #endif
 
+#ifdef ISPC_JIT_ON
+    void SelectJitTarget() {
+        if (m_targets.size() == 1 && m_targets[0] != ISPCTarget::host) {
+            m_jitTarget = m_targets[0];
+            return;
+        }
+        if (m_targets.size() > 1) {
+            return;
+        }
+        // With --cpu the target is derived from the CPU instead.
+        if (m_cpu.empty()) {
+            m_jitTarget = Target::GetHostTarget();
+        }
+    }
+
+    std::string GetJitTarget() const {
+        return m_jitTarget == ISPCTarget::none ? "" : ISPCTargetToString(m_jitTarget);
+    }
+#else
+    void SelectJitTarget() {}
+
+    std::string GetJitTarget() const { return ""; }
+#endif
+
   private:
+#ifdef ISPC_JIT_ON
+    int CompileToJit(const std::string &filename, const Module::VirtualFiles *virtualFiles) {
+        // JIT compilation only supports single target compilation
+        if (m_targets.size() > 1) {
+            Error(SourcePos(), "JIT compilation only supports single target compilation.");
+            return 1;
+        }
+
+        // Initialize JIT if needed
+        if (!InitializeJit()) {
+            return 1;
+        }
+
+        EnableBitcodeLibCache();
+
+        // Compile ISPC file to LLVM module
+        const char *cpu = m_cpu.empty() ? nullptr : m_cpu.c_str();
+        std::vector<ISPCTarget> targets = m_targets;
+        if (m_jitTarget != ISPCTarget::none) {
+            targets = {m_jitTarget};
+        }
+        auto llvmModule = Module::CompileToLLVMModule(filename.c_str(), m_arch, cpu, targets, virtualFiles);
+        if (!llvmModule) {
+            return 1;
+        }
+
+        if (!m_isLazyJit && !m_isJitSpecialization) {
+            // Create a fresh context for this module
+            return AddModuleToJit(std::move(llvmModule), std::make_unique<llvm::LLVMContext>()) ? 0 : 1;
+        }
+
+        // Keep the bitcode for GetSpecializedJitFunction(), the JIT consumes the module
+        std::string bitcode;
+        llvm::raw_string_ostream os(bitcode);
+        llvm::WriteBitcodeToFile(*llvmModule, os);
+        os.flush();
+        std::vector<std::string> definedFunctions;
+        for (const llvm::Function &F : *llvmModule) {
+            if (!F.isDeclaration() && !F.hasLocalLinkage()) {
+                definedFunctions.push_back(F.getName().str());
+            }
+        }
+
+        if (m_isLazyJit) {
+            // Functions are compiled after this call returns, when the global
+            // context may be already gone, so give the JIT a copy of the module
+            // in a context of its own.
+            auto context = std::make_unique<llvm::LLVMContext>();
+            auto moduleOrError = llvm::parseBitcodeFile(llvm::MemoryBufferRef(bitcode, filename), *context);
+            if (!moduleOrError) {
+                Error(SourcePos(), "Failed to read JIT module: %s", llvm::toString(moduleOrError.takeError()).c_str());
+                return 1;
+            }
+            auto tsm = llvm::orc::ThreadSafeModule(std::move(*moduleOrError),
+                                                   llvm::orc::ThreadSafeContext(std::move(context)));
+            auto *lazyJit = static_cast<llvm::orc::LLLazyJIT *>(m_jit.get());
+            if (auto err = lazyJit->addLazyIRModule(std::move(tsm))) {
+                Error(SourcePos(), "Failed to add module to JIT: %s", llvm::toString(std::move(err)).c_str());
+                return 1;
+            }
+        } else if (!AddModuleToJit(std::move(llvmModule), std::make_unique<llvm::LLVMContext>())) {
+            return 1;
+        }
+
+        if (m_isJitSpecialization) {
+            for (const std::string &name : definedFunctions) {
+                m_jitFunctionModules[name] = m_jitBitcode.size();
+            }
+            m_jitBitcode.push_back(std::move(bitcode));
+        }
+        return 0;
+    }
+
+    bool AddModuleToJit(std::unique_ptr<llvm::Module> llvmModule, std::unique_ptr<llvm::LLVMContext> context) {
+        auto tsm = llvm::orc::ThreadSafeModule(std::move(llvmModule), llvm::orc::ThreadSafeContext(std::move(context)));
+
+        auto addResult = m_jit->addIRModule(std::move(tsm));
+        if (addResult) {
+            Error(SourcePos(), "Failed to add module to JIT: %s", llvm::toString(std::move(addResult)).c_str());
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    // Repeated compilations of the engine share the LLVM context, so keep the
+    // parsed builtins and stdlib bitcode instead of reading it again for
+    // every compilation.
+    static void EnableBitcodeLibCache() {
+        if (g->bitcodeLibCache == nullptr) {
+            g->bitcodeLibCache = new BitcodeLibCache();
+        }
+    }
+
+    // Collect the in-memory source and the files it may include.
+    static bool CreateVirtualFiles(const std::string &source, const std::string &filename,
+                                   const std::map<std::string, std::string> &includes, Module::VirtualFiles &files) {
+        if (filename.empty()) {
+            Error(SourcePos(), "Source file name cannot be empty.");
+            return false;
+        }
+        files = includes;
+        files[filename] = source;
+        return true;
+    }
+
     static void writeCompileTimeFile(const char *outFileName) {
         llvm::SmallString<128> jsonFileName(outFileName);
         jsonFileName.append(".json");
@@ -574,6 +1000,7 @@ std::unique_ptr<ISPCEngine> ISPCEngine::CreateFromCArgs(int argc, char *argv[])
     }
 
     instance->pImpl->m_isHelpMode = (parseResult == ArgsParseResult::help_requested);
+    instance->pImpl->SelectJitTarget();
 
     return instance;
 }
@@ -614,16 +1041,38 @@ int ISPCEngine::Execute() { return pImpl->Execute(); }
 
 int ISPCEngine::CompileFromFileToJit(const std::string &filename) { return pImpl->CompileFromFileToJit(filename); }
 
+int ISPCEngine::CompileFromSourceToJit(const std::string &source, const std::string &filename,
+                                       const std::map<std::string, std::string> &includes) {
+    return pImpl->CompileFromSourceToJit(source, filename, includes);
+}
+
+int ISPCEngine::CompileFromSourceToObject(const std::string &source, const std::string &filename,
+                                          std::vector<char> &object,
+                                          const std::map<std::string, std::string> &includes) {
+    return pImpl->CompileFromSourceToObject(source, filename, includes, object);
+}
+
 void *ISPCEngine::GetJitFunction(const std::string &functionName) { return pImpl->GetJitFunction(functionName); }
 
+void *ISPCEngine::GetSpecializedJitFunction(const std::string &functionName,
+                                            const std::map<unsigned, JitParamValue> &params) {
+    return pImpl->GetSpecializedJitFunction(functionName, params);
+}
+
 bool ISPCEngine::IsJitMode() const { return pImpl->IsJitMode(); }
 
+std::string ISPCEngine::GetJitTarget() const { return pImpl->GetJitTarget(); }
+
 void ISPCEngine::ClearJitCode() { pImpl->ClearJitCode(); }
 
 bool ISPCEngine::SetJitRuntimeFunction(const std::string &functionName, void *functionPtr) {
     return pImpl->SetJitRuntimeFunction(functionName, functionPtr);
 }
 
+bool ISPCEngine::SetJitLazyCompilation(bool enable) { return pImpl->SetJitLazyCompilation(enable); }
+
+bool ISPCEngine::SetJitSpecialization(bool enable) { return pImpl->SetJitSpecialization(enable); }
+
 void ISPCEngine::ClearJitRuntimeFunction(const std::string &functionName) {
     pImpl->ClearJitRuntimeFunction(functionName);
 }
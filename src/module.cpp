@@ -11,6 +11,7 @@
 
 #include "module.h"
 #include "builtins.h"
+#include "compile_report.h"
 #include "ctx.h"
 #include "expr.h"
 #include "func.h"
@@ -19,12 +20,16 @@
 #include "opt.h"
 #include "stmt.h"
 #include "sym.h"
+#include "template_cache.h"
 #include "type.h"
 #include "util.h"
 
 #include <algorithm>
+#include <cctype>
+#include <deque>
 #include <fcntl.h>
 #include <fstream>
+#include <future>
 #include <memory>
 #include <set>
 #include <stdarg.h>
@@ -32,9 +37,11 @@
 #include <utility>
 
 #include <clang/Basic/Version.h>
+#include <llvm/Bitcode/BitcodeReader.h>
 #include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/IR/DataLayout.h>
 #include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/GlobalIFunc.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/Module.h>
@@ -42,6 +49,19 @@
 #include <llvm/IR/Verifier.h>
 #include <llvm/IRReader/IRReader.h>
 #include <llvm/Linker/Linker.h>
+#include <llvm/MC/MCAsmBackend.h>
+#include <llvm/MC/MCAsmInfo.h>
+#include <llvm/MC/MCCodeEmitter.h>
+#include <llvm/MC/MCContext.h>
+#include <llvm/MC/MCInstrInfo.h>
+#include <llvm/MC/MCObjectFileInfo.h>
+#include <llvm/MC/MCObjectWriter.h>
+#include <llvm/MC/MCParser/MCAsmParser.h>
+#include <llvm/MC/MCParser/MCTargetAsmParser.h>
+#include <llvm/MC/MCRegisterInfo.h>
+#include <llvm/MC/MCStreamer.h>
+#include <llvm/MC/MCSubtargetInfo.h>
+#include <llvm/MC/TargetRegistry.h>
 #include <llvm/Passes/PassBuilder.h>
 #include <llvm/Support/DynamicLibrary.h>
 #include <llvm/Support/FileUtilities.h>
@@ -50,6 +70,8 @@
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Transforms/IPO/GlobalDCE.h>
+#include <llvm/Transforms/IPO/Internalize.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
 #include <llvm/Transforms/Utils/ValueMapper.h>
 
 #ifdef ISPC_XE_ENABLED
@@ -126,10 +148,16 @@ static bool lIsStdlibPseudoFile(const std::string &name) {
     return false;
 }
 
+/** Returns false for the names of the pseudo files (built-in macros, the
+    stdlib headers, etc.) that are not reported as dependencies. */
+static bool lIsUserDependency(const std::string &fileName) {
+    return fileName[0] != '<' && fileName != "stdlib.ispc" && !lIsStdlibPseudoFile(fileName);
+}
+
 /*! this is where the parser tells us that it has seen the given file
     name in the CPP hash */
 const char *Module::RegisterDependency(const std::string &fileName) {
-    if (fileName[0] != '<' && fileName != "stdlib.ispc" && !lIsStdlibPseudoFile(fileName)) {
+    if (lIsUserDependency(fileName)) {
         auto res = registeredDependencies.insert(fileName);
         return res.first->c_str();
     } else {
@@ -335,10 +363,21 @@ extern int yyparse();
 typedef struct yy_buffer_state *YY_BUFFER_STATE;
 extern void yy_switch_to_buffer(YY_BUFFER_STATE);
 extern YY_BUFFER_STATE yy_create_buffer(FILE *, int);
+extern YY_BUFFER_STATE yy_scan_string(const char *);
 extern void yy_delete_buffer(YY_BUFFER_STATE);
 extern void ParserInit();
 
 int Module::parse() {
+    if (virtualFiles) {
+        auto it = virtualFiles->find(srcFile);
+        if (it != virtualFiles->end()) {
+            YY_BUFFER_STATE strbuf = yy_scan_string(it->second.c_str());
+            yyparse();
+            yy_delete_buffer(strbuf);
+            return 0;
+        }
+    }
+
     // No preprocessor, just open up the file if it's not stdin..
     FILE *f = nullptr;
     if (IsStdin(srcFile)) {
@@ -374,6 +413,7 @@ int Module::CompileFile() {
         }
     } else {
         llvm::TimeTraceScope TimeScope("Frontend parser");
+        CompileReportScope ReportScope("parse");
         if (int err = parse()) {
             return err;
         }
@@ -403,12 +443,16 @@ int Module::CompileFile() {
             f.addFnAttr(SSPAttrKind);
         }
     }
-    ast->GenerateIR();
+    {
+        CompileReportScope ReportScope("generate_ir");
+        ast->GenerateIR();
+    }
 
     debugDumpModule(module, "GenerateIR", pre_stage++);
 
     if (!g->genStdlib) {
         llvm::TimeTraceScope TimeScope("DefineStdlib");
+        CompileReportScope ReportScope("link_stdlib");
         LinkStandardLibraries(module, pre_stage);
     }
 
@@ -429,18 +473,82 @@ int Module::CompileFile() {
         diBuilder->finalize();
     }
 
+    if (!g->genStdlib && errorCount == 0) {
+        restrictExportedFunctions();
+    }
+
+    // Debug info of the instantiations is not shared between compilations.
+    std::unique_ptr<TemplateCache> templateCache;
+    if (!g->genStdlib && !g->templateCacheDir.empty() && errorCount == 0 && diBuilder == nullptr) {
+        llvm::TimeTraceScope TimeScope("TemplateCache");
+        CompileReportScope ReportScope("template_cache");
+        templateCache = std::make_unique<TemplateCache>(g->templateCacheDir);
+        templateCache->Apply(module, templateInstantiations, g->opt.level);
+    }
+
     // Skip optimization for stdlib. We need to consider shipping optimized
     // stdlibs library but at the moment it is not so.
     if (!g->genStdlib) {
         llvm::TimeTraceScope TimeScope("Optimize");
+        CompileReportScope ReportScope("optimize");
         if (errorCount == 0) {
+            std::string target = ISPCTargetToString(g->target->getISPCTarget());
+            if (g->compileReport) {
+                g->compileReport->SetInstructionCount(target, "before_optimization", module->getInstructionCount());
+            }
             Optimize(module, g->opt.level);
+            if (templateCache) {
+                templateCache->Restore(module);
+            }
+            if (g->compileReport) {
+                g->compileReport->SetInstructionCount(target, "after_optimization", module->getInstructionCount());
+            }
         }
     }
 
     return errorCount;
 }
 
+// Returns true if the exported function has the target_clones attribute.
+static bool lHasTargetClones(const Symbol *sym) {
+    return sym->exportedFunction != nullptr && sym->attrs != nullptr && sym->attrs->HasAttribute("target_clones");
+}
+
+void Module::restrictExportedFunctions() {
+    if (isBaselineTarget) {
+        return;
+    }
+
+    std::vector<Symbol *> clonedFuncs;
+    symbolTable->GetMatchingFunctions(lHasTargetClones, &clonedFuncs);
+    if (clonedFuncs.empty()) {
+        // The whole module is compiled for every target.
+        return;
+    }
+
+    std::vector<Symbol *> exportedFuncs;
+    symbolTable->GetMatchingFunctions([](const Symbol *s) { return s->exportedFunction != nullptr; }, &exportedFuncs);
+    for (Symbol *sym : exportedFuncs) {
+        if (lHasTargetClones(sym)) {
+            const std::string &list = sym->attrs->GetAttribute("target_clones")->arg.stringVal;
+            std::vector<ISPCTarget> targets = ParseISPCTargets(list.c_str()).first;
+            if (std::find(targets.begin(), targets.end(), g->target->getISPCTarget()) != targets.end()) {
+                continue;
+            }
+        }
+
+        // Neither the exported function nor its masked version are called
+        // from outside of the module for this target, so they and everything
+        // that only they use are removed by the optimizer. The dispatch
+        // function calls the variant of the baseline target instead.
+        sym->exportedFunction->setLinkage(llvm::GlobalValue::InternalLinkage);
+        if (sym->function != nullptr && !sym->function->isDeclaration()) {
+            sym->function->setLinkage(llvm::GlobalValue::InternalLinkage);
+        }
+        sym->exportedFunction = nullptr;
+    }
+}
+
 void Module::AddTypeDef(const std::string &name, const Type *type, SourcePos pos) {
     // Typedefs are easy; just add the mapping between the given name and
     // the given type.
@@ -810,6 +918,111 @@ void Module::AddGlobalVariable(Declarator *decl, bool isConst) {
     }
 }
 
+// Create the LLVM declaration for a function that has been checked by
+// Module::AddFunctionDeclaration().
+static llvm::Function *lCreateFunctionDeclaration(const std::string &functionName, const FunctionType *functionType,
+                                                  bool isDLLExport, bool isExternCorSYCL, bool isInline,
+                                                  bool isNoInline, const std::string &memory,
+                                                  const std::vector<bool> &noEscapeParams) {
+    llvm::Function *function = functionType->CreateLLVMFunction(functionName, g->ctx, /*disableMask*/ isExternCorSYCL);
+
+    // Make export functions callable from DLLs.
+    if (isDLLExport) {
+        function->setDLLStorageClass(llvm::GlobalValue::DLLExportStorageClass);
+    }
+
+    // Set function attributes: we never throw exceptions
+    function->setDoesNotThrow();
+    if (!isExternCorSYCL && isInline) {
+        function->addFnAttr(llvm::Attribute::AlwaysInline);
+    }
+
+    if (isNoInline) {
+        function->addFnAttr(llvm::Attribute::NoInline);
+    }
+
+    AddUWTableFuncAttr(function);
+
+    if (memory == "none") {
+        function->setDoesNotAccessMemory();
+    } else if (memory == "read") {
+        function->setOnlyReadsMemory();
+    }
+
+    if (functionType->IsTask()) {
+        if (!g->target->isXeTarget()) {
+            // This also applies transitively to members I think?
+            function->addParamAttr(0, llvm::Attribute::NoAlias);
+        }
+    }
+    function->setCallingConv(functionType->GetCallingConv());
+    g->target->markFuncWithTargetAttr(function);
+
+    // Mark with corresponding attribute
+    if (g->target->isXeTarget()) {
+        if (functionType->IsISPCKernel()) {
+            function->addFnAttr("CMGenxMain");
+        } else {
+            function->addFnAttr("CMStackCall");
+        }
+    }
+
+    int nArgs = functionType->GetNumParameters();
+    for (int i = 0; i < nArgs; ++i) {
+        const Type *argType = functionType->GetParameterType(i);
+
+        // ISPC assumes that no pointers alias.  (It should be possible to
+        // specify when this is not the case, but this should be the
+        // default.)  Set parameter attributes accordingly.  (Only for
+        // uniform pointers, since varying pointers are int vectors...)
+        if (!functionType->IsTask() && !functionType->IsExternSYCL() &&
+            ((CastType<PointerType>(argType) != nullptr && argType->IsUniformType() &&
+              // Exclude SOA argument because it is a pair {struct *, int}
+              // instead of pointer
+              !CastType<PointerType>(argType)->IsSlice()) ||
+
+             CastType<ReferenceType>(argType) != nullptr)) {
+
+            function->addParamAttr(i, llvm::Attribute::NoAlias);
+        }
+
+        if (noEscapeParams[i]) {
+#if ISPC_LLVM_VERSION >= ISPC_LLVM_21_0
+            function->addParamAttr(
+                i, llvm::Attribute::getWithCaptureInfo(function->getContext(), llvm::CaptureInfo::none()));
+#else
+            function->addParamAttr(i, llvm::Attribute::NoCapture);
+#endif
+        }
+    }
+
+    // If llvm gave us back a Function * with a different name than the one
+    // we asked for, then there's already a function with that same
+    // (mangled) name in the llvm::Module.  In that case, erase the one we
+    // tried to add and just work with the one it already had.
+    if (function->getName() != functionName) {
+        function->eraseFromParent();
+        function = m->module->getFunction(functionName);
+    }
+    return function;
+}
+
+// The standard library declares a few thousands of functions and a typical
+// program uses only a handful of them. Creating LLVM declarations for all of
+// them takes noticeable time for small programs and makes the linker pull in
+// all of their definitions from the stdlib bitcode (see LinkStandardLibraries),
+// just to have them removed later. So the LLVM declarations of the functions
+// declared in the implicitly included stdlib.isph are created on first use.
+// Functions from core.isph and unmangled functions are still declared eagerly
+// because the compiler looks them up by name in the LLVM module.
+static bool lIsDeferredDeclaration(const FunctionType *functionType, const SourcePos &pos) {
+    if (g->genStdlib || pos.name == nullptr || functionType->IsUnmangled() || functionType->IsExternC() ||
+        functionType->IsExported()) {
+        return false;
+    }
+    return !m->stdlibHeaderName.empty() && m->stdlibHeaderName == pos.name;
+}
+
 /** Given an arbitrary type, see if it or any of the leaf types contained
     in it has a type that's illegal to have exported to C/C++
     code.
@@ -1057,24 +1270,12 @@ void Module::AddFunctionDeclaration(const std::string &name, const FunctionType
             return;
         }
     }
-    llvm::Function *function = functionType->CreateLLVMFunction(functionName, g->ctx, /*disableMask*/ isExternCorSYCL);
-
-    if (g->target_os == TargetOS::windows) {
-        // Make export functions callable from DLLs.
-        if ((g->dllExport) && !storageClass.IsStatic()) {
-            function->setDLLStorageClass(llvm::GlobalValue::DLLExportStorageClass);
-        }
-    }
+    bool isDLLExport = (g->target_os == TargetOS::windows) && g->dllExport && !storageClass.IsStatic();
 
     if (isNoInline && isInline) {
         Error(pos, "Illegal to use \"noinline\" and \"inline\" qualifiers together on function \"%s\".", name.c_str());
         return;
     }
-    // Set function attributes: we never throw exceptions
-    function->setDoesNotThrow();
-    if (!isExternCorSYCL && isInline) {
-        function->addFnAttr(llvm::Attribute::AlwaysInline);
-    }
 
     if (isVectorCall) {
         if (!storageClass.IsExternC()) {
@@ -1095,33 +1296,30 @@ void Module::AddFunctionDeclaration(const std::string &name, const FunctionType
         }
     }
 
-    if (isNoInline) {
-        function->addFnAttr(llvm::Attribute::NoInline);
-    }
-
-    AddUWTableFuncAttr(function);
-
+    std::string memory;
     if (const auto &al = decl->attributeList) {
         if (al->HasAttribute("memory")) {
-            const auto &memory = al->GetAttribute("memory")->arg.stringVal;
-            if (memory == "none") {
-                function->setDoesNotAccessMemory();
-            } else if (memory == "read") {
-                function->setOnlyReadsMemory();
-            } else {
+            memory = al->GetAttribute("memory")->arg.stringVal;
+            if (memory != "none" && memory != "read") {
                 Error(pos, "Unknown memory attribute \"%s\".", memory.c_str());
             }
         }
-    }
-
-    if (functionType->IsTask()) {
-        if (!g->target->isXeTarget()) {
-            // This also applies transitively to members I think?
-            function->addParamAttr(0, llvm::Attribute::NoAlias);
+        if (al->HasAttribute("target_clones")) {
+            const Attribute *clones = al->GetAttribute("target_clones");
+            if (!functionType->IsExported()) {
+                Warning(pos, "Ignoring \"target_clones\" attribute of non-exported function \"%s\".", name.c_str());
+            } else if (clones->arg.kind != ATTR_ARG_STRING) {
+                Error(pos, "\"target_clones\" attribute of function \"%s\" expects a string with a list of targets.",
+                      name.c_str());
+            } else {
+                std::string unknownTargets = ParseISPCTargets(clones->arg.stringVal.c_str()).second;
+                if (!unknownTargets.empty()) {
+                    Warning(pos, "Ignoring unknown targets \"%s\" in \"target_clones\" attribute of function \"%s\".",
+                            unknownTargets.c_str(), name.c_str());
+                }
+            }
         }
     }
-    function->setCallingConv(functionType->GetCallingConv());
-    g->target->markFuncWithTargetAttr(function);
 
     // Make sure that the return type isn't 'varying' or vector typed if
     // the function is 'export'ed.
@@ -1142,19 +1340,11 @@ void Module::AddFunctionDeclaration(const std::string &name, const FunctionType
         lCheckForStructParameters(functionType, pos);
     }
 
-    // Mark with corresponding attribute
-    if (g->target->isXeTarget()) {
-        if (functionType->IsISPCKernel()) {
-            function->addFnAttr("CMGenxMain");
-        } else {
-            function->addFnAttr("CMStackCall");
-        }
-    }
-
     // Loop over all of the arguments; process default values if present
-    // and do other checks and parameter attribute setting.
+    // and do other checks.
     bool seenDefaultArg = false;
     int nArgs = functionType->GetNumParameters();
+    std::vector<bool> noEscapeParams(nArgs, false);
     for (int i = 0; i < nArgs; ++i) {
         const Type *argType = functionType->GetParameterType(i);
         const std::string &argName = functionType->GetParameterName(i);
@@ -1173,21 +1363,6 @@ void Module::AddFunctionDeclaration(const std::string &name, const FunctionType
         }
 #endif
 
-        // ISPC assumes that no pointers alias.  (It should be possible to
-        // specify when this is not the case, but this should be the
-        // default.)  Set parameter attributes accordingly.  (Only for
-        // uniform pointers, since varying pointers are int vectors...)
-        if (!functionType->IsTask() && !functionType->IsExternSYCL() &&
-            ((CastType<PointerType>(argType) != nullptr && argType->IsUniformType() &&
-              // Exclude SOA argument because it is a pair {struct *, int}
-              // instead of pointer
-              !CastType<PointerType>(argType)->IsSlice()) ||
-
-             CastType<ReferenceType>(argType) != nullptr)) {
-
-            function->addParamAttr(i, llvm::Attribute::NoAlias);
-        }
-
         Assert(decl && decl->functionParams.size() == static_cast<size_t>(nArgs));
         DeclSpecs *declSpecs = decl->functionParams[i]->declSpecs;
         AttributeList *attrList = declSpecs ? declSpecs->attributeList : nullptr;
@@ -1197,12 +1372,7 @@ void Module::AddFunctionDeclaration(const std::string &name, const FunctionType
 
             if (attrList->HasAttribute("noescape")) {
                 if (argType->IsPointerType() && argType->IsUniformType()) {
-#if ISPC_LLVM_VERSION >= ISPC_LLVM_21_0
-                    function->addParamAttr(
-                        i, llvm::Attribute::getWithCaptureInfo(function->getContext(), llvm::CaptureInfo::none()));
-#else
-                    function->addParamAttr(i, llvm::Attribute::NoCapture);
-#endif
+                    noEscapeParams[i] = true;
                 }
 
                 if (argType->IsVaryingType()) {
@@ -1237,20 +1407,19 @@ void Module::AddFunctionDeclaration(const std::string &name, const FunctionType
         }
     }
 
-    // If llvm gave us back a Function * with a different name than the one
-    // we asked for, then there's already a function with that same
-    // (mangled) name in the llvm::Module.  In that case, erase the one we
-    // tried to add and just work with the one it already had.
-    if (function->getName() != functionName) {
-        function->eraseFromParent();
-        function = module->getFunction(functionName);
-    }
-
     // Finally, we know all is good and we can add the function to the
     // symbol table
     Symbol *funSym =
         new Symbol(name, pos, Symbol::SymbolKind::Function, functionType, storageClass, decl->attributeList);
-    funSym->function = function;
+    auto createFunction = [=]() {
+        return lCreateFunctionDeclaration(functionName, functionType, isDLLExport, isExternCorSYCL, isInline,
+                                          isNoInline, memory, noEscapeParams);
+    };
+    if (lIsDeferredDeclaration(functionType, pos)) {
+        funSym->deferredFunction = createFunction;
+    } else {
+        funSym->function = createFunction();
+    }
     bool ok = symbolTable->AddFunction(funSym);
     Assert(ok);
 }
@@ -1570,6 +1739,10 @@ bool Module::writeOutput() {
     switch (outputType) {
     case Asm:
     case Object:
+        if (backendWorkers) {
+            backendWorkers->Enqueue(module, g->target->GetTargetMachine(), output.out, outputType);
+            return true;
+        }
         return writeObjectFileOrAssembly(module, output);
     case Bitcode:
     case BitcodeText:
@@ -1801,44 +1974,332 @@ bool Module::writeZEBin() {
 }
 #endif // ISPC_XE_ENABLED
 
-bool Module::writeObjectFileOrAssembly(llvm::Module *M, Output &CO) {
-    llvm::TargetMachine *targetMachine = g->target->GetTargetMachine();
+// Run LLVM code generation for the given module and write the result to os.
+static void lEmitToStream(llvm::Module *M, llvm::TargetMachine *targetMachine, llvm::raw_pwrite_stream &os,
+                          llvm::CodeGenFileType fileType) {
+    llvm::legacy::PassManager pm;
+
+    // Third parameter is for generation of .dwo file, which is separate DWARF
+    // file for ELF targets. We don't support it currently.
+    if (targetMachine->addPassesToEmitFile(pm, os, nullptr, fileType)) {
+        FATAL("Failed to add passes to emit object file!");
+    }
+
+    // Finally, run the passes to emit the object file/assembly
+    pm.run(*M);
+}
+
+// Code generation of split modules goes through textual assembly, so it is
+// limited to the object file format which the concatenation is known to work
+// for. Debug info is not supported, as every partition would have its own
+// line table and file numbering, and neither is module level inline
+// assembly, which every partition would get a copy of.
+static bool lCanSplitCodeGen(llvm::Module *M, llvm::TargetMachine *targetMachine) {
+    return targetMachine->getTargetTriple().isOSBinFormatELF() && !g->generateDebuggingSymbols &&
+           M->getModuleInlineAsm().empty();
+}
+
+// Create a copy of the target machine for a code generation thread.
+static std::unique_ptr<llvm::TargetMachine> lCloneTargetMachine(llvm::TargetMachine *TM) {
+    const llvm::Target &target = TM->getTarget();
+#if ISPC_LLVM_VERSION >= ISPC_LLVM_21_0
+    llvm::TargetMachine *clone =
+        target.createTargetMachine(TM->getTargetTriple(), TM->getTargetCPU(), TM->getTargetFeatureString(),
+                                   TM->Options, TM->getRelocationModel(), TM->getCodeModel(), TM->getOptLevel());
+#else
+    llvm::TargetMachine *clone =
+        target.createTargetMachine(TM->getTargetTriple().str(), TM->getTargetCPU(), TM->getTargetFeatureString(),
+                                   TM->Options, TM->getRelocationModel(), TM->getCodeModel(), TM->getOptLevel());
+#endif
+    return std::unique_ptr<llvm::TargetMachine>(clone);
+}
+
+// Make the private labels (.LBB0_1, .LCPI0_0, .Lfunc_end0, ...) of a
+// partition's assembly unique by inserting the partition number after the
+// ".L" prefix. The partitions are compiled independently, so their label
+// numbering starts from zero in each of them. String literals and comments,
+// which start with commentString, are copied unchanged.
+static std::string lRenamePrivateLabels(const std::string &text, int partition, llvm::StringRef commentString) {
+    std::string prefix = ".L" + std::to_string(partition) + "_";
+    std::string result;
+    result.reserve(text.size() + text.size() / 16);
+    for (size_t i = 0; i < text.size(); ++i) {
+        size_t end = i;
+        if (text[i] == '"') {
+            for (++end; end < text.size() && text[end] != '"' && text[end] != '\n'; ++end) {
+                if (text[end] == '\\') {
+                    ++end;
+                }
+            }
+            end = std::min(end + 1, text.size());
+        } else if (!commentString.empty() && llvm::StringRef(text).substr(i).starts_with(commentString)) {
+            end = std::min(text.find('\n', i), text.size());
+        }
+        if (end > i) {
+            result.append(text, i, end - i);
+            i = end - 1;
+            continue;
+        }
+
+        bool atLabel = text.compare(i, 2, ".L") == 0;
+        if (atLabel && i > 0) {
+            char prev = text[i - 1];
+            atLabel = !(std::isalnum(static_cast<unsigned char>(prev)) || prev == '_' || prev == '.' || prev == '$');
+        }
+        if (atLabel) {
+            result += prefix;
+            ++i;
+        } else {
+            result += text[i];
+        }
+    }
+    return result;
+}
+
+// Assemble the given assembly text into an object file.
+static bool lAssemble(const std::string &text, llvm::TargetMachine *TM, llvm::raw_pwrite_stream &os) {
+    const llvm::Target &target = TM->getTarget();
+    const llvm::Triple &triple = TM->getTargetTriple();
+    llvm::MCTargetOptions mcOptions = TM->Options.MCOptions;
+
+    llvm::SourceMgr srcMgr;
+    srcMgr.AddNewSourceBuffer(llvm::MemoryBuffer::getMemBuffer(text, "<split codegen>"), llvm::SMLoc());
+
+    std::unique_ptr<llvm::MCRegisterInfo> MRI(target.createMCRegInfo(triple.str()));
+    std::unique_ptr<llvm::MCAsmInfo> MAI(target.createMCAsmInfo(*MRI, triple.str(), mcOptions));
+    std::unique_ptr<llvm::MCSubtargetInfo> STI(
+        target.createMCSubtargetInfo(triple.str(), TM->getTargetCPU(), TM->getTargetFeatureString()));
+    std::unique_ptr<llvm::MCInstrInfo> MCII(target.createMCInstrInfo());
+    if (!MRI || !MAI || !STI || !MCII) {
+        return false;
+    }
+
+    llvm::MCContext ctx(triple, MAI.get(), MRI.get(), STI.get(), &srcMgr, &mcOptions);
+    std::unique_ptr<llvm::MCObjectFileInfo> MOFI(target.createMCObjectFileInfo(ctx, TM->isPositionIndependent()));
+    ctx.setObjectFileInfo(MOFI.get());
+
+    std::unique_ptr<llvm::MCCodeEmitter> CE(target.createMCCodeEmitter(*MCII, ctx));
+    std::unique_ptr<llvm::MCAsmBackend> MAB(target.createMCAsmBackend(*STI, *MRI, mcOptions));
+    if (!CE || !MAB) {
+        return false;
+    }
+    std::unique_ptr<llvm::MCObjectWriter> OW = MAB->createObjectWriter(os);
+#if ISPC_LLVM_VERSION >= ISPC_LLVM_19_0
+    std::unique_ptr<llvm::MCStreamer> streamer(
+        target.createMCObjectStreamer(triple, ctx, std::move(MAB), std::move(OW), std::move(CE), *STI));
+#else
+    std::unique_ptr<llvm::MCStreamer> streamer(
+        target.createMCObjectStreamer(triple, ctx, std::move(MAB), std::move(OW), std::move(CE), *STI,
+                                      mcOptions.MCRelaxAll, mcOptions.MCIncrementalLinkerCompatible, false));
+#endif
+
+    std::unique_ptr<llvm::MCAsmParser> parser(llvm::createMCAsmParser(srcMgr, ctx, *streamer, *MAI));
+    std::unique_ptr<llvm::MCTargetAsmParser> targetParser(
+        target.createMCAsmParser(*STI, *parser, *MCII, mcOptions));
+    if (!targetParser) {
+        return false;
+    }
+    parser->setTargetParser(*targetParser);
+    return !parser->Run(false);
+}
+
+// Split the module into up to numPartitions parts and run code generation
+// for them on separate threads, similar to LLVM's parallel code generation
+// for LTO. The assembly of the partitions is concatenated and, for object
+// output, assembled again, so the result is a single file as usual.
+// Returns false without writing anything to os if any step fails.
+static bool lSplitCodeGen(llvm::Module *M, llvm::TargetMachine *targetMachine, int numPartitions,
+                          llvm::raw_pwrite_stream &os, llvm::CodeGenFileType fileType) {
+    // Local symbols stay in the partition of their users, so the only names
+    // that can clash after concatenation are the private labels.
+    std::vector<llvm::SmallVector<char, 0>> partitions;
+    llvm::SplitModule(
+        *M, numPartitions,
+        [&](std::unique_ptr<llvm::Module> part) {
+            partitions.emplace_back();
+            llvm::raw_svector_ostream bos(partitions.back());
+            llvm::WriteBitcodeToFile(*part, bos);
+        },
+        /* PreserveLocals */ true);
+
+    // Every job returns the assembly of its partition or an empty string on failure.
+    std::vector<std::future<std::string>> jobs;
+    for (size_t i = 0; i < partitions.size(); ++i) {
+        const llvm::SmallVector<char, 0> &bitcode = partitions[i];
+        jobs.push_back(std::async(std::launch::async, [&bitcode, targetMachine, i]() -> std::string {
+            llvm::LLVMContext context;
+            llvm::MemoryBufferRef buffer(llvm::StringRef(bitcode.data(), bitcode.size()), "partition");
+            llvm::Expected<std::unique_ptr<llvm::Module>> part = llvm::parseBitcodeFile(buffer, context);
+            std::unique_ptr<llvm::TargetMachine> TM = lCloneTargetMachine(targetMachine);
+            if (!part || !TM) {
+                llvm::consumeError(part.takeError());
+                return "";
+            }
+            llvm::SmallString<0> text;
+            llvm::raw_svector_ostream tos(text);
+            lEmitToStream(part->get(), TM.get(), tos, llvm::CodeGenFileType::AssemblyFile);
+            return lRenamePrivateLabels(text.str().str(), i, TM->getMCAsmInfo()->getCommentString());
+        }));
+    }
+
+    std::string text;
+    bool failed = false;
+    for (auto &job : jobs) {
+        std::string partText = job.get();
+        failed |= partText.empty();
+        text += partText;
+        text += "\n";
+    }
+    if (failed) {
+        return false;
+    }
+
+    if (fileType == llvm::CodeGenFileType::AssemblyFile) {
+        os << text;
+        return true;
+    }
+    llvm::SmallVector<char, 0> object;
+    llvm::raw_svector_ostream oos(object);
+    if (!lAssemble(text, targetMachine, oos)) {
+        return false;
+    }
+    os << llvm::StringRef(object.data(), object.size());
+    return true;
+}
+
+// Run LLVM code generation for the given module and write the resulting
+// object file or assembly to outFileName. This function doesn't touch any
+// ispc global state, so it may be called from a worker thread, provided that
+// neither the module nor the target machine are used by anybody else at the
+// same time. Returns false if the output file can't be opened.
+static bool lEmitObjectFileOrAssembly(llvm::Module *M, llvm::TargetMachine *targetMachine,
+                                      const std::string &outFileName, Module::OutputType type,
+                                      int numPartitions = 1) {
     Assert(targetMachine);
 
     // Figure out if we're generating object file or assembly output, and
     // set binary output for object files
     llvm::CodeGenFileType fileType =
-        (CO.type == Object) ? llvm::CodeGenFileType::ObjectFile : llvm::CodeGenFileType::AssemblyFile;
+        (type == Module::Object) ? llvm::CodeGenFileType::ObjectFile : llvm::CodeGenFileType::AssemblyFile;
     bool binary = (fileType == llvm::CodeGenFileType::ObjectFile);
     llvm::sys::fs::OpenFlags flags = binary ? llvm::sys::fs::OF_None : llvm::sys::fs::OF_Text;
 
     std::error_code error;
 
-    std::unique_ptr<llvm::ToolOutputFile> of(new llvm::ToolOutputFile(CO.out, error, flags));
+    std::unique_ptr<llvm::ToolOutputFile> of(new llvm::ToolOutputFile(outFileName, error, flags));
 
     if (error) {
+        return false;
+    }
+
+    bool split = numPartitions > 1 && lCanSplitCodeGen(M, targetMachine);
+    if (split && !lSplitCodeGen(M, targetMachine, numPartitions, of->os(), fileType)) {
+        Warning(SourcePos(), "Split code generation failed, generating code on a single thread.");
+        split = false;
+    }
+    if (!split) {
+        lEmitToStream(M, targetMachine, of->os(), fileType);
+    }
+
+    // Success; tell tool_output_file to keep the final output file.
+    of->keep();
+    return true;
+}
+
+bool Module::writeObjectFileOrAssembly(llvm::Module *M, Output &CO) {
+    // With --jobs, code generation of a single target is split across threads.
+    if (!lEmitObjectFileOrAssembly(M, g->target->GetTargetMachine(), CO.out, CO.type, g->numJobs)) {
         Error(SourcePos(), "Cannot open output file \"%s\".\n", CO.out.c_str());
         return false;
     }
+    return true;
+}
 
-    llvm::legacy::PassManager pm;
+namespace ispc {
+/** Pool of threads that run the backend (object file or assembly emission)
+    for target modules of multi-target compilation, while the main thread
+    continues with the front-end and the optimization of the next target.
+
+    The front-end relies on global state (g->target, m, g->ctx and the
+    parser), so only the code generation is moved to the workers. Each
+    queued module is serialized to bitcode on the main thread and then
+    parsed by the worker into its own LLVMContext. The target machine is
+    owned by the module's Target, which is not used by the main thread until
+    Wait() returns. */
+class BackendWorkers {
+  public:
+    explicit BackendWorkers(int numJobs) : numJobs(numJobs) {}
+    ~BackendWorkers() { Wait(); }
+
+    BackendWorkers(const BackendWorkers &) = delete;
+    BackendWorkers &operator=(const BackendWorkers &) = delete;
+
+    /** Snapshot the given module and schedule its code generation. If all
+        the workers are busy, block until the oldest job is finished. */
+    void Enqueue(llvm::Module *module, llvm::TargetMachine *targetMachine, const std::string &outFileName,
+                 Module::OutputType type) {
+        auto bitcode = std::make_shared<llvm::SmallVector<char, 0>>();
+        llvm::raw_svector_ostream bos(*bitcode);
+        llvm::WriteBitcodeToFile(*module, bos);
+
+        while (pending.size() >= static_cast<size_t>(numJobs)) {
+            collectOldest();
+        }
+
+        CompileReport *report = g->compileReport;
+        std::string target = ISPCTargetToString(g->target->getISPCTarget());
+        pending.push_back(std::async(std::launch::async, [bitcode, targetMachine, outFileName, type, report, target]() {
+            auto start = std::chrono::steady_clock::now();
+            std::string err = lRunJob(*bitcode, targetMachine, outFileName, type);
+            if (report) {
+                report->AddPhaseTime(target, "backend",
+                                     std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            }
+            return err;
+        }));
+    }
 
-    {
-        llvm::raw_fd_ostream &fos(of->os());
-        // Third parameter is for generation of .dwo file, which is separate DWARF
-        // file for ELF targets. We don't support it currently.
-        if (targetMachine->addPassesToEmitFile(pm, fos, nullptr, fileType)) {
-            FATAL("Failed to add passes to emit object file!");
+    /** Wait for all scheduled jobs and report their errors. Returns the
+        number of failed jobs. */
+    int Wait() {
+        while (!pending.empty()) {
+            collectOldest();
         }
+        int result = errorCount;
+        errorCount = 0;
+        return result;
+    }
 
-        // Finally, run the passes to emit the object file/assembly
-        pm.run(*M);
+  private:
+    // Returns an error message or an empty string on success.
+    static std::string lRunJob(const llvm::SmallVector<char, 0> &bitcode, llvm::TargetMachine *targetMachine,
+                               const std::string &outFileName, Module::OutputType type) {
+        llvm::LLVMContext context;
+        llvm::MemoryBufferRef buffer(llvm::StringRef(bitcode.data(), bitcode.size()), outFileName);
+        llvm::Expected<std::unique_ptr<llvm::Module>> M = llvm::parseBitcodeFile(buffer, context);
+        if (!M) {
+            return "Failed to read back module for \"" + outFileName + "\": " + llvm::toString(M.takeError());
+        }
+        if (!lEmitObjectFileOrAssembly(M->get(), targetMachine, outFileName, type)) {
+            return "Cannot open output file \"" + outFileName + "\".";
+        }
+        return "";
+    }
 
-        // Success; tell tool_output_file to keep the final output file.
-        of->keep();
+    void collectOldest() {
+        std::string err = pending.front().get();
+        pending.pop_front();
+        if (!err.empty()) {
+            Error(SourcePos(), "%s", err.c_str());
+            ++errorCount;
+        }
     }
-    return true;
-}
+
+    int numJobs;
+    int errorCount{0};
+    std::deque<std::future<std::string>> pending;
+};
+} // namespace ispc
 
 // Given an output filename of the form "foo.obj", and a Target
 // return a string with the ISA name inserted before the original
@@ -1941,6 +2402,47 @@ static llvm::FunctionType *lGetVaryingDispatchType(FunctionTargetVariants &funcs
     return resultFuncTy;
 }
 
+/** Create a GNU indirect function for an exported ispc function. The resolver
+    runs once, when the dynamic loader binds the symbol, and returns the best
+    variant the system can run, so the calls go directly to it. */
+static void lCreateDispatchIFunc(llvm::Module *module, llvm::FunctionType *ftype, const std::string &functionName,
+                                 const std::string &name, llvm::Function *targetFuncs[]) {
+    // The resolver may run before the C library is initialized, so it uses the
+    // variant of __get_system_best_isa() that doesn't call getenv().
+    llvm::Function *getBestISAFunc = module->getFunction(builtin::__get_system_best_isa_ifunc);
+    Assert(getBestISAFunc);
+
+    auto *ptrTy = llvm::PointerType::getUnqual(*g->ctx);
+    llvm::Function *resolver = llvm::Function::Create(llvm::FunctionType::get(ptrTy, false),
+                                                      llvm::GlobalValue::InternalLinkage, "__resolve_" + name, module);
+    AddUWTableFuncAttr(resolver);
+
+    llvm::IRBuilder builder(llvm::BasicBlock::Create(*g->ctx, "entry", resolver));
+    llvm::Value *systemISA = builder.CreateCall(getBestISAFunc, {}, "system_isa");
+
+    // Same as in lCreateDispatchFunction(): return the first variant,
+    // from the most capable one, that the system can run.
+    for (int i = Target::NUM_ISAS - 1; i >= 0; --i) {
+        if (targetFuncs[i] == nullptr) {
+            continue;
+        }
+        llvm::Value *ok = builder.CreateICmpSGE(systemISA, LLVMInt32(i), "isa_ok");
+        llvm::BasicBlock *retBBlock = llvm::BasicBlock::Create(*g->ctx, "do_return", resolver);
+        llvm::BasicBlock *nextBBlock = llvm::BasicBlock::Create(*g->ctx, "next_try", resolver);
+        builder.CreateCondBr(ok, retBBlock, nextBBlock);
+        builder.SetInsertPoint(retBBlock);
+        builder.CreateRet(targetFuncs[i]);
+        builder.SetInsertPoint(nextBBlock);
+    }
+
+    llvm::Function *abortFunc = module->getFunction(builtin::__terminate_now);
+    Assert(abortFunc);
+    builder.CreateCall(abortFunc);
+    builder.CreateUnreachable();
+
+    llvm::GlobalIFunc::create(ftype, 0, llvm::GlobalValue::ExternalLinkage, functionName, resolver, module);
+}
+
 /** Create the dispatch function for an exported ispc function.
     This function checks to see which vector ISAs the system the
     code is running on supports and calls out to the best available
@@ -1996,6 +2498,11 @@ static void lCreateDispatchFunction(llvm::Module *module, llvm::Function *getBes
         g->target->markFuncNameWithRegCallPrefix(functionName);
     }
 
+    if (g->dispatchMode == Globals::DispatchMode::IFunc) {
+        lCreateDispatchIFunc(module, ftype, functionName, name, targetFuncs);
+        return;
+    }
+
     // Now we can emit the definition of the dispatch function..
     llvm::Function *dispatchFunc =
         llvm::Function::Create(ftype, llvm::GlobalValue::ExternalLinkage, functionName.c_str(), module);
@@ -2321,6 +2828,9 @@ int Module::WriteOutputFiles() {
     if (!output.header.empty() && !writeHeader()) {
         return 1;
     }
+    if (!output.fingerprint.empty() && !writeInterfaceFingerprint()) {
+        return 1;
+    }
     if (!output.nbWrap.empty() && !writeNanobindWrapper()) {
         return 1;
     }
@@ -2369,6 +2879,10 @@ int Module::CompileSingleTarget(Arch arch, const char *cpu, ISPCTarget target) {
 
     if (compileResult == 0) {
         llvm::TimeTraceScope TimeScope("Backend");
+        // With backend workers, the workers report the time of code generation
+        // as "backend", while this thread only snapshots the module and waits
+        // for a free worker.
+        CompileReportScope ReportScope(backendWorkers ? "backend_queue" : "backend");
 
         if (lValidateXeTargetOutputType(g->target, output.type)) {
             return 1;
@@ -2547,6 +3061,7 @@ int Module::GenerateDispatch(const char *srcFile, std::vector<ISPCTarget> &targe
     if (!DHI.initialize(output.header)) {
         return 1;
     }
+    InterfaceFingerprint fingerprint;
 
     // Create the dispatch module,
     llvm::Module *dispatchModule = lInitDispatchModule();
@@ -2581,11 +3096,18 @@ int Module::GenerateDispatch(const char *srcFile, std::vector<ISPCTarget> &targe
         if (!output.header.empty() && !m->writeDispatchHeader(&DHI)) {
             return 1;
         }
+        if (!output.fingerprint.empty()) {
+            fingerprint.add(m);
+        }
 
         // Just precausiously reset observers to nullptr to avoid dangling pointers.
         lResetTargetAndModule();
     }
 
+    if (!output.fingerprint.empty() && !fingerprint.write(output.fingerprint)) {
+        return 1;
+    }
+
     // Set the module that corresponds to the common target ISA
     lResetTargetAndModule(modules, targetsPtrs, commonTargetIndex);
 
@@ -2625,6 +3147,10 @@ static Module::Output lCreateTargetOutputs(Module::Output &output, ISPCTarget ta
     targetOutputs.hostStub = "";
     targetOutputs.devStub = "";
 
+    // The interface fingerprint covers all the targets, it is written during
+    // the dispatch module generation.
+    targetOutputs.fingerprint = "";
+
     // Disable writing dependencies file for individual targets.
     // deps file is written only once for all targets, so we will generate
     // it during the dispatch module generation.
@@ -2654,6 +3180,22 @@ int Module::CompileMultipleTargets(const char *srcFile, Arch arch, const char *c
     std::vector<std::unique_ptr<Module>> modules;
     std::vector<std::unique_ptr<Target>> targetsPtrs;
 
+    // With --jobs=N, code generation of the already optimized target modules
+    // runs on worker threads in parallel with compilation of the next ones.
+    // It has to be declared after targetsPtrs, so the workers are joined
+    // before the target machines that they use are destroyed.
+    std::unique_ptr<BackendWorkers> backendWorkers;
+    if (g->numJobs > 1 && (output.type == Object || output.type == Asm)) {
+        backendWorkers = std::make_unique<BackendWorkers>(g->numJobs);
+    }
+
+    // Exported functions that aren't multi-versioned with the target_clones
+    // attribute are compiled only for the least capable target.
+    auto [baselineISA, baselineIndex] = lCheckAndFillISAIndices(targets);
+    if (baselineIndex == -1) {
+        return 1;
+    }
+
     for (unsigned int i = 0; i < targets.size(); ++i) {
         auto targetPtr = Target::Create(arch, cpu, targets[i], output.flags.getPICLevel(), output.flags.getMCModel(),
                                         g->printTarget);
@@ -2674,6 +3216,8 @@ int Module::CompileMultipleTargets(const char *srcFile, Arch arch, const char *c
         // Transfer the ownership of the module to the vector, i.e., the
         // lifetime of the module objects is tied to the function scope.
         modules.push_back(std::move(modulePtr));
+        m->backendWorkers = backendWorkers.get();
+        m->isBaselineTarget = (static_cast<int>(i) == baselineIndex);
 
         int compilerResult = m->CompileSingleTarget(arch, cpu, targets[i]);
         if (compilerResult) {
@@ -2687,6 +3231,12 @@ int Module::CompileMultipleTargets(const char *srcFile, Arch arch, const char *c
         lResetTargetAndModule();
     }
 
+    // The dispatch module is compiled with the target machine of one of the
+    // targets, so all the workers must be done at this point.
+    if (backendWorkers && backendWorkers->Wait()) {
+        return 1;
+    }
+
     // Generate the dispatch module
     return GenerateDispatch(srcFile, targets, modules, targetsPtrs, output);
 }
@@ -2720,8 +3270,66 @@ int Module::CompileAndOutput(const char *srcFile, Arch arch, const char *cpu, st
     }
 }
 
+int Module::ScanDependencies(const std::vector<std::string> &srcFiles, Arch arch, const char *cpu,
+                             std::vector<ISPCTarget> &targets, Module::Output &output) {
+    std::vector<ISPCTarget> scanTargets(targets);
+    if (scanTargets.empty()) {
+        scanTargets.push_back(ISPCTarget::none);
+    }
+
+    // The targets are created once for all the files; the preprocessor only
+    // needs the macros they define.
+    std::vector<std::unique_ptr<Target>> targetsPtrs;
+    for (ISPCTarget target : scanTargets) {
+        auto targetPtr =
+            Target::Create(arch, cpu, target, output.flags.getPICLevel(), output.flags.getMCModel(), g->printTarget);
+        if (!targetPtr) {
+            g->target = nullptr;
+            return 1;
+        }
+        targetsPtrs.push_back(std::move(targetPtr));
+    }
+
+    FILE *file = !output.deps.empty() ? fopen(output.deps.c_str(), "w") : stdout;
+    if (!file) {
+        perror("fopen");
+        g->target = nullptr;
+        return 1;
+    }
+
+    int errors = 0;
+    for (const std::string &srcFile : srcFiles) {
+        std::set<std::string> scanned;
+        int fileErrors = 0;
+        for (const auto &targetPtr : targetsPtrs) {
+            g->target = targetPtr.get();
+            fileErrors += scanDependencies(srcFile.c_str(), scanned);
+        }
+        errors += fileErrors;
+        if (fileErrors != 0) {
+            continue;
+        }
+
+        std::set<std::string> dependencies;
+        for (const std::string &name : scanned) {
+            if (lIsUserDependency(name)) {
+                dependencies.insert(name);
+            }
+        }
+        printDeps(file, output.DepsTargetName(srcFile.c_str()), srcFile.c_str(), dependencies,
+                  output.flags.isMakeRuleDeps());
+    }
+    g->target = nullptr;
+
+    if (file != stdout) {
+        fclose(file);
+    }
+    return errors;
+}
+
 std::unique_ptr<llvm::Module> Module::CompileToLLVMModule(const char *srcFile, Arch arch, const char *cpu,
-                                                          std::vector<ISPCTarget> &targets) {
+                                                          std::vector<ISPCTarget> &targets,
+                                                          const VirtualFiles *virtualFiles) {
     // We need to ensure we have a proper target set up
     if (!g->target) {
         // Create a default target for JIT compilation
@@ -2742,6 +3350,7 @@ std::unique_ptr<llvm::Module> Module::CompileToLLVMModule(const char *srcFile, A
 
     // Create a temporary ISPC module for compilation
     auto tempModule = std::make_unique<Module>(srcFile);
+    tempModule->virtualFiles = virtualFiles;
 
     // Set the global module pointer for the duration of compilation
     m = tempModule.get();
@@ -2771,7 +3380,34 @@ std::unique_ptr<llvm::Module> Module::CompileToLLVMModule(const char *srcFile, A
     return std::unique_ptr<llvm::Module>(llvmModule);
 }
 
-int Module::LinkAndOutput(std::vector<std::string> linkFiles, OutputType outputType, std::string outFileName) {
+int Module::CompileToObjectBuffer(const char *srcFile, Arch arch, const char *cpu, std::vector<ISPCTarget> &targets,
+                                  const VirtualFiles *virtualFiles, std::vector<char> &object) {
+    std::unique_ptr<llvm::Module> llvmModule = CompileToLLVMModule(srcFile, arch, cpu, targets, virtualFiles);
+    if (!llvmModule) {
+        return 1;
+    }
+
+    if (g->generateDebuggingSymbols && !llvmModule->getModuleFlag("Debug Info Version")) {
+        llvmModule->addModuleFlag(llvm::Module::Warning, "Debug Info Version", llvm::DEBUG_METADATA_VERSION);
+    }
+
+    // SIC! (verifyModule() == TRUE) means "failed", see llvm-link code.
+    if (llvm::verifyModule(*llvmModule, &llvm::errs())) {
+        FATAL("Resulting module verification failed!");
+        return 1;
+    }
+
+    llvm::SmallVector<char, 0> buffer;
+    llvm::raw_svector_ostream os(buffer);
+    lEmitToStream(llvmModule.get(), g->target->GetTargetMachine(), os, llvm::CodeGenFileType::ObjectFile);
+    object.assign(buffer.begin(), buffer.end());
+    return 0;
+}
+
+int Module::LinkAndOutput(std::vector<std::string> linkFiles, Arch arch, const char *cpu,
+                          std::vector<ISPCTarget> &targets, Output &output) {
+    OutputType outputType = output.type;
+    const std::string &outFileName = output.out;
     auto llvmLink = std::make_unique<llvm::Module>("llvm-link", *g->ctx);
     llvm::Linker linker(*llvmLink);
     for (const auto &file : linkFiles) {
@@ -2799,16 +3435,48 @@ int Module::LinkAndOutput(std::vector<std::string> linkFiles, OutputType outputT
         }
         inputStream.close();
     }
+
+    // Optimization and native code generation need the target of the linked
+    // files; the arguments parser makes sure that there is exactly one.
+    std::unique_ptr<Target> target;
+    if (g->optimizeLinkedModule || outputType == Object || outputType == Asm) {
+        Assert(targets.size() == 1);
+        target = Target::Create(arch, cpu, targets[0], output.flags.getPICLevel(), output.flags.getMCModel(), false);
+        if (!target) {
+            return 1;
+        }
+    }
+
+    if (g->optimizeLinkedModule) {
+        // The linked files are treated as the whole program, so ISPC functions
+        // with mangled names, which can't be called from C/C++, are made
+        // internal. This allows the optimizer to inline them across the files
+        // and to remove the ones that are no longer used.
+        llvm::internalizeModule(*llvmLink, [](const llvm::GlobalValue &GV) {
+            return !llvm::isa<llvm::Function>(GV) || GV.getName().find("___") == llvm::StringRef::npos;
+        });
+        Optimize(llvmLink.get(), g->opt.level);
+    }
+
+    int result = 1;
     if (!outFileName.empty()) {
+        result = 0;
         if ((outputType == Bitcode) || (outputType == BitcodeText)) {
             writeBitcode(llvmLink.get(), outFileName, outputType);
+        } else if (outputType == Object || outputType == Asm) {
+            if (!lEmitObjectFileOrAssembly(llvmLink.get(), target->GetTargetMachine(), outFileName, outputType)) {
+                Error(SourcePos(), "Cannot open output file \"%s\".\n", outFileName.c_str());
+                result = 1;
+            }
         }
 #ifdef ISPC_XE_ENABLED
         else if (outputType == SPIRV) {
             writeSPIRV(llvmLink.get(), outFileName);
         }
 #endif
-        return 0;
     }
-    return 1;
+    if (target) {
+        g->target = nullptr;
+    }
+    return result;
 }
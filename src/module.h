@@ -16,7 +16,9 @@
 #include "ispc.h"
 
 #include <algorithm>
+#include <map>
 #include <memory>
+#include <set>
 #include <stdio.h>
 #include <string>
 #include <vector>
@@ -36,6 +38,8 @@ class raw_string_ostream;
 
 namespace ispc {
 
+class BackendWorkers;
+
 #ifdef ISPC_XE_ENABLED
 // Derived from ocloc_api.h
 using invokePtr = int (*)(unsigned, const char **, const uint32_t, const uint8_t **, const uint64_t *, const char **,
@@ -264,12 +268,13 @@ class Module {
         std::string depsTarget{};
 
         // Output file names
-        std::string out{};      /**< Main output file name */
-        std::string header{};   /**< Header file name */
-        std::string nbWrap{};   /**< Nanobind wrapper file name */
-        std::string deps{};     /**< Dependencies file name */
-        std::string hostStub{}; /**< Host stub file name */
-        std::string devStub{};  /**< Device stub file name */
+        std::string out{};         /**< Main output file name */
+        std::string header{};      /**< Header file name */
+        std::string nbWrap{};      /**< Nanobind wrapper file name */
+        std::string deps{};        /**< Dependencies file name */
+        std::string hostStub{};    /**< Host stub file name */
+        std::string devStub{};     /**< Device stub file name */
+        std::string fingerprint{}; /**< Interface fingerprint file name */
 
         /**
          * Get the target name for dependencies
@@ -312,17 +317,50 @@ class Module {
         bool Emit4 = false;
         bool Emit8 = false;
         bool Emit16 = false;
+        bool Complete = false;
         FILE *file = nullptr;
         const char *fn = nullptr;
         std::string header{};
+        std::string tmpHeader{};
 
         bool initialize(std::string headerFileName);
 
+        /**
+         * Closes the file. A complete header replaces the header file unless
+         * the file already has the same content; an incomplete one is
+         * discarded.
+         */
         void closeFile();
 
         ~DispatchHeaderInfo() { closeFile(); }
     };
 
+    /**
+     * @class InterfaceFingerprint
+     * Hashes of the declarations of the exported functions and of the
+     * explicitly exported types, as they appear in the generated header,
+     * including the declarations of the types used by function parameters.
+     * Build systems can compare them to skip rebuilding the code that
+     * includes the header when the exported interface doesn't change.
+     */
+    class InterfaceFingerprint {
+      public:
+        /** Adds the exported interface of the module. For multi-target
+            compilation it is called for the module of every target. */
+        void add(const Module *module);
+
+        /** Writes the fingerprint file unless it already has the same
+            content. Returns false on error, including failures of add(). */
+        bool write(const std::string &fileName) const;
+
+      private:
+        /** Declarations of the functions and types, indexed by name. */
+        std::map<std::string, std::string> m_functions;
+        std::map<std::string, std::string> m_types;
+        /** False if some of the declarations couldn't be captured. */
+        bool m_complete{true};
+    };
+
     /**
      * @enum CompilationMode
      * Defines whether the module is being compiled alone or as part of a multi-target compilation
@@ -366,13 +404,44 @@ class Module {
     static int CompileAndOutput(const char *srcFile, Arch arch, const char *cpu, std::vector<ISPCTarget> &targets,
                                 Output &output);
 
-    static std::unique_ptr<llvm::Module> CompileToLLVMModule(const char *srcFile, Arch arch, const char *cpu,
-                                                             std::vector<ISPCTarget> &targets);
+    /** Files that are read from memory instead of the file system, mapping
+        file name to file content. Relative names are relative to the
+        current directory. */
+    using VirtualFiles = std::map<std::string, std::string>;
 
-    static int LinkAndOutput(std::vector<std::string> linkFiles, OutputType outputType, std::string outFileName);
+    /** Compile the given source file for a single target and return the
+        resulting optimized LLVM module. If virtualFiles is not null, the
+        source file and the files it includes are looked up there first. */
+    static std::unique_ptr<llvm::Module> CompileToLLVMModule(const char *srcFile, Arch arch, const char *cpu,
+                                                             std::vector<ISPCTarget> &targets,
+                                                             const VirtualFiles *virtualFiles = nullptr);
+
+    /** Same as CompileToLLVMModule(), but the module is compiled further to
+        an object file, which is written to the given buffer. Returns the
+        number of errors. */
+    static int CompileToObjectBuffer(const char *srcFile, Arch arch, const char *cpu, std::vector<ISPCTarget> &targets,
+                                     const VirtualFiles *virtualFiles, std::vector<char> &object);
+
+    /** Links the given LLVM bitcode or SPIR-V files and writes the result.
+        With g->optimizeLinkedModule, the linked module is optimized as a
+        whole for the given target; object and assembly outputs are compiled
+        for it too. Returns the number of errors. */
+    static int LinkAndOutput(std::vector<std::string> linkFiles, Arch arch, const char *cpu,
+                             std::vector<ISPCTarget> &targets, Output &output);
+
+    /** Writes the dependencies of the given source files as -M or -MMM
+        would, running only the preprocessor: no module is created and the
+        files are not parsed. The files included for any of the targets are
+        reported. Returns the number of errors. */
+    static int ScanDependencies(const std::vector<std::string> &srcFiles, Arch arch, const char *cpu,
+                                std::vector<ISPCTarget> &targets, Output &output);
 
     const char *RegisterDependency(const std::string &fileName);
 
+    /** Run the preprocessor on the source file and write its output to the
+        given string. Returns the number of preprocessor errors. */
+    int Preprocess(std::string &result);
+
     /** Total number of errors encountered during compilation. */
     int errorCount{0};
 
@@ -398,8 +467,19 @@ class Module {
         is handled by lMangleStructName() below. */
     std::map<std::string, llvm::StructType *> structTypeMap;
 
+    /** Names of the LLVM functions generated for template instantiations and
+        specializations, used by the template cache (see --template-cache-dir). */
+    std::vector<std::string> templateInstantiations;
+
+    /** Name of the implicitly included stdlib.isph header as it appears in
+        SourcePos::name: a virtual path for the composite binary, the path
+        found in the include directories for the slim binary. Empty if the
+        standard library isn't included. */
+    std::string stdlibHeaderName;
+
   private:
     const char *srcFile{nullptr};
+    const VirtualFiles *virtualFiles{nullptr};
     AST *ast{nullptr};
 
     Output output{};
@@ -409,6 +489,16 @@ class Module {
 
     std::vector<std::pair<const Type *, SourcePos>> exportedTypes;
 
+    /** When non-null, object file/assembly emission is not done in place but
+        handed over to the worker threads (see --jobs). It is set only for
+        target modules of multi-target compilation. */
+    BackendWorkers *backendWorkers{nullptr};
+
+    /** False for the target modules of multi-target compilation other than
+        the one of the least capable target, which contain only the exported
+        functions multi-versioned for them (see restrictExportedFunctions). */
+    bool isBaselineTarget{true};
+
     const std::vector<OutputTypeInfo> outputTypeInfos = {
         /* Asm         */ {"assembly", {"s"}},
         /* Bitcode     */ {"LLVM bitcode", {"bc"}},
@@ -494,6 +584,13 @@ class Module {
      */
     int WriteOutputFiles();
 
+    /** If some exported functions of the module are multi-versioned with the
+        target_clones attribute, gives internal linkage to the exported
+        functions that aren't multi-versioned for the current target, so that
+        they are compiled only for the baseline target of multi-target
+        compilation. */
+    void restrictExportedFunctions();
+
     /** Check if the given output type is valid for the specified file name
       suffix. If not, print a warning message. Correct suffixes are defined in
       outputTypeInfos. */
@@ -509,6 +606,7 @@ class Module {
     void writeHeader(FILE *f);
     bool writeNanobindWrapper();
     bool writeDispatchHeader(DispatchHeaderInfo *DHI);
+    bool writeInterfaceFingerprint();
 
     /**
      * Generates a dependency file in make-compatible format.
@@ -519,6 +617,16 @@ class Module {
      * @return True on success, false if file creation or writing failed
      */
     bool writeDeps(Output &customOutput);
+
+    /** Prints the dependencies of srcFile to the file, either as a make rule
+        for targetName or as a flat list. */
+    static void printDeps(FILE *file, const std::string &targetName, const char *srcFile,
+                          const std::set<std::string> &dependencies, bool generateMakeRule);
+
+    /** Runs the preprocessor on srcFile for the current target and adds the
+        names of the files it includes to dependencies. Returns the number of
+        errors. */
+    static int scanDependencies(const char *srcFile, std::set<std::string> &dependencies);
     bool writeDevStub();
     bool writeHostStub();
     bool writeCPPStub();
@@ -9,6 +9,7 @@
 */
 
 #include "opt.h"
+#include "compile_report.h"
 #include "ctx.h"
 #include "llvmutil.h"
 #include "module.h"
@@ -143,6 +144,9 @@ DebugModulePassManager::DebugModulePassManager(llvm::Module &M, int optLevel) :
         // Enable time traces for optimization passes.
         TimePasses.registerCallbacks(PIC);
     }
+    if (g->compileReport) {
+        g->compileReport->RegisterPassCallbacks(PIC, ISPCTargetToString(g->target->getISPCTarget()));
+    }
     // Create the new pass manager builder using our target machine.
     pb = llvm::PassBuilder(targetMachine, llvm::PipelineTuningOptions(), std::nullopt, &PIC);
 
@@ -440,6 +444,10 @@ void ispc::Optimize(llvm::Module *module, int optLevel) {
 
         // Next inline pass will remove functions, saved by __keep_funcs_live
         optPM.addModulePass(llvm::ModuleInlinerWrapperPass(IP));
+        // Only the calls that weren't inlined are left to specialize.
+        if (g->opt.disableUniformArgSpecialization == false) {
+            optPM.addModulePass(SpecializeUniformArgsPass());
+        }
 
         optPM.initFunctionPassManager();
         optPM.addFunctionPass(llvm::InstSimplifyPass());
@@ -491,6 +499,7 @@ void ispc::Optimize(llvm::Module *module, int optLevel) {
                 // finding matching gathers we can coalesce..
                 optPM.addFunctionPass(llvm::EarlyCSEPass(), 260);
                 optPM.addFunctionPass(GatherCoalescePass());
+                optPM.addFunctionPass(ScatterCoalescePass());
             }
         }
         optPM.commitFunctionToModulePassManager();
@@ -508,6 +517,11 @@ void ispc::Optimize(llvm::Module *module, int optLevel) {
         if (g->opt.disableGatherScatterOptimizations == false && g->target->getVectorWidth() > 1) {
             optPM.addFunctionPass(llvm::InferAlignmentPass());
             optPM.addFunctionPass(llvm::InstCombinePass(), 270);
+            // Versioning comes first, so that the masked loads and stores of
+            // the contiguous versions are improved when the mask is all on.
+            if (g->opt.disableGatherScatterVersioning == false) {
+                optPM.addFunctionPass(GatherScatterVersioningPass());
+            }
             optPM.addFunctionPass(ImproveMemoryOpsPass());
         }
         optPM.commitFunctionToModulePassManager();
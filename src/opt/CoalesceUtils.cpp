@@ -0,0 +1,103 @@
+/*
+  Copyright (c) 2026, Intel Corporation
+
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+/** @file CoalesceUtils.cpp
+    @brief Helpers shared by GatherCoalescePass and ScatterCoalescePass.
+*/
+
+#include "CoalesceUtils.h"
+
+namespace ispc {
+
+bool GetCoalescingOperands(llvm::CallInst *callInst, CoalescingOperands *ops) {
+    // Scatters have the stored values as an additional operand.
+    const bool isScatter = callInst->getType()->isVoidTy();
+    const unsigned nFactoredArgs = isScatter ? 6 : 5;
+
+    llvm::Value *constOffsets = nullptr;
+    int64_t constScale = 1;
+    ops->base = callInst->getArgOperand(0);
+    if (callInst->arg_size() == nFactoredArgs) {
+        ops->variableOffsets = callInst->getArgOperand(1);
+        ops->scale = callInst->getArgOperand(2);
+        constOffsets = callInst->getArgOperand(3);
+    } else {
+        Assert(callInst->arg_size() == nFactoredArgs - 1);
+        ops->scale = callInst->getArgOperand(1);
+        llvm::Value *offsets = callInst->getArgOperand(2);
+        auto *scale = llvm::dyn_cast<llvm::ConstantInt>(ops->scale);
+        if (scale == nullptr) {
+            return false;
+        }
+        constScale = scale->getSExtValue();
+
+        llvm::Value *zero = llvm::Constant::getNullValue(offsets->getType());
+        llvm::BinaryOperator *bop = llvm::dyn_cast<llvm::BinaryOperator>(offsets);
+        if (llvm::isa<llvm::Constant>(offsets)) {
+            ops->variableOffsets = zero;
+            constOffsets = offsets;
+        } else if (bop != nullptr && (bop->getOpcode() == llvm::Instruction::Add || IsOrEquivalentToAdd(bop)) &&
+                   llvm::isa<llvm::Constant>(bop->getOperand(1))) {
+            ops->variableOffsets = bop->getOperand(0);
+            constOffsets = bop->getOperand(1);
+        } else {
+            ops->variableOffsets = offsets;
+            constOffsets = zero;
+        }
+    }
+    unsigned nArgs = callInst->arg_size();
+    ops->values = isScatter ? callInst->getArgOperand(nArgs - 2) : nullptr;
+    ops->mask = callInst->getArgOperand(nArgs - 1);
+
+    int width = g->target->getVectorWidth();
+    ops->constOffsets.assign(width, 0);
+    int nElts = 0;
+    if (!LLVMExtractVectorInts(constOffsets, ops->constOffsets.data(), &nElts) || nElts != width) {
+        return false;
+    }
+    for (int64_t &offset : ops->constOffsets) {
+        offset *= constScale;
+    }
+    return true;
+}
+
+llvm::Value *ComputeCoalescedBasePtr(const CoalescingOperands &ops, llvm::Type *baseType,
+                                     llvm::Instruction *insertBefore) {
+    llvm::Value *offsetScale = ops.scale;
+    // All of the variable offsets values are the same, so extract the
+    // first value and use that as a scalar.
+    llvm::Value *variable = LLVMExtractFirstVectorElement(ops.variableOffsets);
+    Assert(variable != nullptr);
+    if (variable->getType() == LLVMTypes::Int64Type) {
+        offsetScale = new llvm::ZExtInst(offsetScale, LLVMTypes::Int64Type, "scale_to64",
+                                         ISPC_INSERTION_POINT_INSTRUCTION(insertBefore));
+    }
+    llvm::Value *offset = llvm::BinaryOperator::Create(llvm::Instruction::Mul, variable, offsetScale, "offset",
+                                                       ISPC_INSERTION_POINT_INSTRUCTION(insertBefore));
+
+    return LLVMGEPInst(ops.base, baseType, offset, "new_base", insertBefore);
+}
+
+bool ExtractCoalescedConstOffsets(const std::vector<llvm::CallInst *> &coalesceGroup, int elementSize,
+                                  std::vector<int64_t> *constOffsets) {
+    constOffsets->clear();
+    for (llvm::CallInst *callInst : coalesceGroup) {
+        CoalescingOperands ops;
+        bool ok = GetCoalescingOperands(callInst, &ops);
+        Assert(ok);
+        constOffsets->insert(constOffsets->end(), ops.constOffsets.begin(), ops.constOffsets.end());
+    }
+
+    for (int i = 0; i < (int)constOffsets->size(); ++i) {
+        if ((*constOffsets)[i] % elementSize != 0) {
+            return false;
+        }
+        (*constOffsets)[i] /= elementSize;
+    }
+    return true;
+}
+
+} // namespace ispc
@@ -0,0 +1,66 @@
+/*
+  Copyright (c) 2026, Intel Corporation
+
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+/** @file CoalesceUtils.h
+    @brief Helpers shared by GatherCoalescePass and ScatterCoalescePass.
+*/
+
+#pragma once
+
+#include "ISPCPass.h"
+
+#include <vector>
+
+namespace ispc {
+
+/** The operands of a factored or non-factored pseudo gather or scatter in
+    terms of the factored form: lane i accesses
+    base + scale * variableOffsets[i] + constOffsets[i].
+ */
+struct CoalescingOperands {
+    llvm::Value *base{nullptr};
+    llvm::Value *variableOffsets{nullptr};
+    llvm::Value *scale{nullptr};
+    /** The constant offsets in bytes, one per lane. */
+    std::vector<int64_t> constOffsets;
+    /** The stored values; nullptr for gathers. */
+    llvm::Value *values{nullptr};
+    llvm::Value *mask{nullptr};
+};
+
+/** Extracts the operands of the given call of a pseudo gather or scatter.
+    The factored ones, which targets without hardware gathers or scatters
+    use, are (base, varyingOffsets, scale, constOffsets, [values,] mask).
+    The non-factored ones are (base, scale, offsets, [values,] mask); their
+    offsets are split into a constant vector and the rest when they are a
+    constant or the sum of a constant and another value.  No instructions
+    are emitted.  Returns false if the constant offsets aren't known
+    integers.
+ */
+bool GetCoalescingOperands(llvm::CallInst *callInst, CoalescingOperands *ops);
+
+/** Computes the scalar base pointer shared by a group of gathers or
+    scatters with the given operands, from the base pointer, the 2/4/8
+    scale and the first varying offsets value; all of the varying offsets
+    must have the same value.  The base pointer plus the constant offsets of
+    each gather or scatter of the group gives its addresses.
+ */
+llvm::Value *ComputeCoalescedBasePtr(const CoalescingOperands &ops, llvm::Type *baseType,
+                                     llvm::Instruction *insertBefore);
+
+/** Extracts the constant offsets from the common base pointer of each of
+    the gathers or scatters of a group into constOffsets, the ones of the
+    first call first.  They come in as byte offsets, but are transformed
+    into offsets in terms of the element size.  (e.g. for an i32 gather, we
+    might have offsets like <0,4,16,20>, which would be transformed to
+    <0,1,4,5> here.)  Returns false if some offset isn't a multiple of the
+    element size, so the elements can't be accessed as vectors of the
+    element type.
+ */
+bool ExtractCoalescedConstOffsets(const std::vector<llvm::CallInst *> &coalesceGroup, int elementSize,
+                                  std::vector<int64_t> *constOffsets);
+
+} // namespace ispc
@@ -5,8 +5,12 @@
 */
 
 #include "GatherCoalescePass.h"
+#include "CoalesceUtils.h"
 #include "builtins-decl.h"
 
+#include <algorithm>
+#include <llvm/IR/IRBuilder.h>
+
 namespace ispc {
 
 /** Representation of a memory load that the gather coalescing code has
@@ -137,7 +141,8 @@ static bool lVectorLoadIsEfficient(std::set<int64_t>::iterator iter, std::set<in
     many as possible wider vector loads rather than scalar loads).  Return
     a CoalescedLoadOp for each one in the *loads array.
  */
-static void lSelectLoads(const std::vector<int64_t> &loadOffsets, std::vector<CoalescedLoadOp> *loads) {
+static void lSelectLoads(const std::vector<int64_t> &loadOffsets, const std::vector<int> &vectorWidths,
+                         std::vector<CoalescedLoadOp> *loads) {
     // First, get a sorted set of unique offsets to load from.
     std::set<int64_t> allOffsets;
     for (unsigned int i = 0; i < loadOffsets.size(); ++i) {
@@ -156,11 +161,9 @@ static void lSelectLoads(const std::vector<int64_t> &loadOffsets, std::vector<Co
     iter = allOffsets.begin();
     while (iter != allOffsets.end()) {
         // Consider vector loads of width of each of the elements of
-        // spanSizes[], in order.
-        int vectorWidths[] = {8, 4, 2};
-        int nVectorWidths = sizeof(vectorWidths) / sizeof(vectorWidths[0]);
+        // vectorWidths[], in order.
         bool gotOne = false;
-        for (int i = 0; i < nVectorWidths; ++i) {
+        for (int i = 0; i < (int)vectorWidths.size(); ++i) {
             // See if a load of vector with width vectorWidths[i] would be
             // effective (i.e. would cover a reasonable number of the
             // offsets that need to be loaded from).
@@ -709,56 +712,6 @@ static void lAssembleResultVectors(const std::vector<CoalescedLoadOp> &loadOps,
     }
 }
 
-/** Given a call to a gather function, extract the base pointer, the 2/4/8
-    scale, and the first varying offsets value to use them to compute that
-    scalar base pointer that is shared by all of the gathers in the group.
-    (Thus, this base pointer plus the constant offsets term for each gather
-    gives the set of addresses to use for each gather.
- */
-static llvm::Value *lComputeBasePtr(llvm::CallInst *gatherInst, llvm::Type *baseType, llvm::Instruction *insertBefore) {
-    llvm::Value *basePtr = gatherInst->getArgOperand(0);
-    llvm::Value *variableOffsets = gatherInst->getArgOperand(1);
-    llvm::Value *offsetScale = gatherInst->getArgOperand(2);
-    // All of the variable offsets values should be the same, due to
-    // checking for this in GatherCoalescePass::runOnBasicBlock().  Thus,
-    // extract the first value and use that as a scalar.
-    llvm::Value *variable = LLVMExtractFirstVectorElement(variableOffsets);
-    Assert(variable != nullptr);
-    if (variable->getType() == LLVMTypes::Int64Type) {
-        offsetScale = new llvm::ZExtInst(offsetScale, LLVMTypes::Int64Type, "scale_to64",
-                                         ISPC_INSERTION_POINT_INSTRUCTION(insertBefore));
-    }
-    llvm::Value *offset = llvm::BinaryOperator::Create(llvm::Instruction::Mul, variable, offsetScale, "offset",
-                                                       ISPC_INSERTION_POINT_INSTRUCTION(insertBefore));
-
-    return LLVMGEPInst(basePtr, baseType, offset, "new_base", insertBefore);
-}
-
-/** Extract the constant offsets (from the common base pointer) from each
-    of the gathers in a set to be coalesced.  These come in as byte
-    offsets, but we'll transform them into offsets in terms of the size of
-    the base scalar type being gathered.  (e.g. for an i32 gather, we might
-    have offsets like <0,4,16,20>, which would be transformed to <0,1,4,5>
-    here.)
- */
-static void lExtractConstOffsets(const std::vector<llvm::CallInst *> &coalesceGroup, int elementSize,
-                                 std::vector<int64_t> *constOffsets) {
-    int width = g->target->getVectorWidth();
-    *constOffsets = std::vector<int64_t>(coalesceGroup.size() * width, 0);
-
-    int64_t *endPtr = &((*constOffsets)[0]);
-    for (int i = 0; i < (int)coalesceGroup.size(); ++i, endPtr += width) {
-        llvm::Value *offsets = coalesceGroup[i]->getArgOperand(3);
-        int nElts = 0;
-        bool ok = LLVMExtractVectorInts(offsets, endPtr, &nElts);
-        Assert(ok && nElts == width);
-    }
-
-    for (int i = 0; i < (int)constOffsets->size(); ++i) {
-        (*constOffsets)[i] /= elementSize;
-    }
-}
-
 /** Actually do the coalescing.  We have a set of gathers all accessing
     addresses of the form:
 
@@ -768,35 +721,36 @@ static void lExtractConstOffsets(const std::vector<llvm::CallInst *> &coalesceGr
     where varyingOffset actually has the same value across all of the SIMD
     lanes and where the part in parenthesis has the same value for all of
     the gathers in the group.
+
+    This is the variant for gathers of 32-bit values with the mask all on;
+    the others are handled by lCoalesceGathersGeneric().
  */
 static bool lCoalesceGathers(const std::vector<llvm::CallInst *> &coalesceGroup, llvm::Type *baseType) {
     llvm::Instruction *insertBefore = coalesceGroup[0];
 
-    // First, compute the shared base pointer for all of the gathers
-    llvm::Value *basePtr = lComputeBasePtr(coalesceGroup[0], baseType, insertBefore);
-
-    int elementSize = 0;
-    if (coalesceGroup[0]->getType() == LLVMTypes::Int32VectorType ||
-        coalesceGroup[0]->getType() == LLVMTypes::FloatVectorType) {
-        elementSize = 4;
-    } else if (coalesceGroup[0]->getType() == LLVMTypes::Int64VectorType ||
-               coalesceGroup[0]->getType() == LLVMTypes::DoubleVectorType) {
-        elementSize = 8;
-    } else {
-        FATAL("Unexpected gather type in lCoalesceGathers");
-    }
+    Assert(coalesceGroup[0]->getType() == LLVMTypes::Int32VectorType ||
+           coalesceGroup[0]->getType() == LLVMTypes::FloatVectorType);
+    const int elementSize = 4;
 
     // Extract the constant offsets from the gathers into the constOffsets
     // vector: the first vectorWidth elements will be those for the first
     // gather, the next vectorWidth those for the next gather, and so
     // forth.
     std::vector<int64_t> constOffsets;
-    lExtractConstOffsets(coalesceGroup, elementSize, &constOffsets);
+    if (!ExtractCoalescedConstOffsets(coalesceGroup, elementSize, &constOffsets)) {
+        return false;
+    }
+
+    // Compute the shared base pointer for all of the gathers
+    CoalescingOperands ops;
+    bool ok = GetCoalescingOperands(coalesceGroup[0], &ops);
+    Assert(ok);
+    llvm::Value *basePtr = ComputeCoalescedBasePtr(ops, baseType, insertBefore);
 
     // Determine a set of loads to perform to get all of the values we need
     // loaded.
     std::vector<CoalescedLoadOp> loadOps;
-    lSelectLoads(constOffsets, &loadOps);
+    lSelectLoads(constOffsets, {8, 4, 2}, &loadOps);
 
     lCoalescePerfInfo(coalesceGroup, loadOps);
 
@@ -840,6 +794,177 @@ static bool lCoalesceGathers(const std::vector<llvm::CallInst *> &coalesceGroup,
     return true;
 }
 
+/** Returns the widths of the vector loads, in elements, that
+    lCoalesceGathersGeneric() considers for gathers of the given width:
+    powers of two down to 2 elements, and up to the gather width and to the
+    size of the widest native vector register (64 bytes). */
+static std::vector<int> lGenericLoadWidths(int gatherWidth, int elementSize) {
+    std::vector<int> widths;
+    for (int w = 2; w <= gatherWidth && w * elementSize <= 64; w *= 2) {
+        widths.insert(widths.begin(), w);
+    }
+    return widths;
+}
+
+/** Converts the mask of a gather to a vector of i1 with a true element for
+    every active lane. */
+static llvm::Value *lMaskToI1(llvm::IRBuilder<> &builder, llvm::Value *mask) {
+    auto *maskType = llvm::cast<llvm::FixedVectorType>(mask->getType());
+    if (maskType->getElementType()->isIntegerTy(1)) {
+        return mask;
+    }
+    return builder.CreateICmpNE(mask, llvm::Constant::getNullValue(maskType), "mask_i1");
+}
+
+/** Computes the mask of a masked load covering the elements
+    [load.start, load.start + load.count): an element is loaded if an active
+    lane of any of the gathers needs it. laneMask is the mask of the gathers
+    as a vector of i1 (see lMaskToI1()), and neededLanes tells which of the
+    constOffsets need to be loaded. */
+static llvm::Value *lComputeLoadMask(llvm::IRBuilder<> &builder, llvm::Value *laneMask, const CoalescedLoadOp &load,
+                                     const std::vector<int64_t> &constOffsets, const std::vector<bool> &neededLanes,
+                                     int width) {
+    // lanes[j] holds the lanes that need element j of the load.  Several
+    // lanes need the same element when the gathers of the group overlap.
+    std::vector<std::vector<int>> lanes(load.count);
+    size_t maxLanes = 0;
+    for (int i = 0; i < (int)constOffsets.size(); ++i) {
+        int64_t elt = constOffsets[i] - load.start;
+        if (neededLanes[i] && elt >= 0 && elt < load.count) {
+            lanes[elt].push_back(i % width);
+            maxLanes = std::max(maxLanes, lanes[elt].size());
+        }
+    }
+
+    // Shuffle the lane mask for the r-th lane that needs each element and
+    // OR the results; the elements that no lane needs select the first
+    // (false) element of the all-false second operand.
+    llvm::Value *allOff = llvm::Constant::getNullValue(laneMask->getType());
+    llvm::Value *loadMask = nullptr;
+    for (size_t r = 0; r < maxLanes; ++r) {
+        llvm::SmallVector<int, 16> shuf(load.count, width);
+        for (int j = 0; j < load.count; ++j) {
+            if (r < lanes[j].size()) {
+                shuf[j] = lanes[j][r];
+            }
+        }
+        llvm::Value *m = builder.CreateShuffleVector(laneMask, allOff, shuf, "load_mask");
+        loadMask = loadMask ? builder.CreateOr(loadMask, m, "load_mask") : m;
+    }
+    Assert(loadMask != nullptr);
+    return loadMask;
+}
+
+/** Coalesces a group of gathers of elements of any size, with any mask.
+    The loads are chosen in the same way as by lCoalesceGathers(), but they
+    are vector loads of the element type of the gathers, which are then
+    shuffled into the results.
+
+    Lanes that are known to be off at compile time don't need any value.
+    When the mask isn't known, the loads are emitted as masked loads that
+    only access the elements needed by the active lanes, so no memory that
+    the original gathers wouldn't access is accessed.
+ */
+static bool lCoalesceGathersGeneric(const std::vector<llvm::CallInst *> &coalesceGroup, llvm::Type *baseType) {
+    llvm::CallInst *firstGather = coalesceGroup[0];
+    auto *resultType = llvm::cast<llvm::FixedVectorType>(firstGather->getType());
+    llvm::Type *elementType = resultType->getElementType();
+    const int width = resultType->getNumElements();
+    const llvm::DataLayout *dl = g->target->getDataLayout();
+    const int elementSize = dl->getTypeStoreSize(elementType);
+    const llvm::Align align = dl->getABITypeAlign(elementType);
+
+    std::vector<int64_t> constOffsets;
+    if (!ExtractCoalescedConstOffsets(coalesceGroup, elementSize, &constOffsets)) {
+        return false;
+    }
+
+    CoalescingOperands ops;
+    bool ok = GetCoalescingOperands(firstGather, &ops);
+    Assert(ok);
+    llvm::Value *mask = ops.mask;
+    uint64_t maskBits = 0;
+    const bool maskIsKnown = GetMaskFromValue(mask, &maskBits);
+    std::vector<bool> neededLanes(constOffsets.size(), true);
+    std::vector<int64_t> neededOffsets;
+    for (int i = 0; i < (int)constOffsets.size(); ++i) {
+        if (maskIsKnown && (maskBits & (1ull << (i % width))) == 0) {
+            neededLanes[i] = false;
+        } else {
+            neededOffsets.push_back(constOffsets[i]);
+        }
+    }
+    if (neededOffsets.empty()) {
+        return false;
+    }
+
+    std::vector<CoalescedLoadOp> loadOps;
+    lSelectLoads(neededOffsets, lGenericLoadWidths(width, elementSize), &loadOps);
+
+    // Masked scalar loads aren't any better than the original gathers.
+    if (!maskIsKnown && std::all_of(loadOps.begin(), loadOps.end(), [](auto &op) { return op.count == 1; })) {
+        return false;
+    }
+
+    lCoalescePerfInfo(coalesceGroup, loadOps);
+
+    llvm::Value *basePtr = ComputeCoalescedBasePtr(ops, baseType, firstGather);
+    llvm::IRBuilder<> builder(firstGather);
+    llvm::Value *laneMask = maskIsKnown ? nullptr : lMaskToI1(builder, mask);
+
+    // Emit the loads, as vectors of loadOps[i].count elements, and widen
+    // them to the width of the gathers, so they can be shuffled with the
+    // results.
+    std::vector<llvm::Value *> widenedLoads;
+    for (CoalescedLoadOp &load : loadOps) {
+        auto *loadType = llvm::FixedVectorType::get(elementType, load.count);
+        llvm::Value *ptr = LLVMGEPInst(basePtr, baseType, LLVMInt64(load.start * elementSize), "new_base", firstGather);
+        if (laneMask != nullptr) {
+            llvm::Value *loadMask = lComputeLoadMask(builder, laneMask, load, constOffsets, neededLanes, width);
+            load.load = builder.CreateMaskedLoad(loadType, ptr, align, loadMask, nullptr, "gather_load");
+        } else {
+            load.load = builder.CreateAlignedLoad(loadType, ptr, align, "gather_load");
+        }
+
+        llvm::SmallVector<int, 16> widen(width, -1);
+        for (int j = 0; j < load.count; ++j) {
+            widen[j] = j;
+        }
+        widenedLoads.push_back(load.count == width ? load.load
+                                                   : builder.CreateShuffleVector(load.load, widen, "gather_load"));
+    }
+
+    // Assemble the result of each gather from the loads that cover its
+    // lanes; the lanes that are known to be off stay undefined.
+    for (int gi = 0; gi < (int)coalesceGroup.size(); ++gi) {
+        const int64_t *offsets = &constOffsets[gi * width];
+        llvm::Value *result = llvm::UndefValue::get(resultType);
+        for (int li = 0; li < (int)loadOps.size(); ++li) {
+            const CoalescedLoadOp &load = loadOps[li];
+            llvm::SmallVector<int, 16> shuf(width);
+            bool anyMatched = false;
+            for (int lane = 0; lane < width; ++lane) {
+                shuf[lane] = width + lane;
+                if (neededLanes[gi * width + lane] && offsets[lane] >= load.start &&
+                    offsets[lane] < load.start + load.count) {
+                    shuf[lane] = int(offsets[lane] - load.start);
+                    anyMatched = true;
+                }
+            }
+            if (anyMatched) {
+                result = builder.CreateShuffleVector(widenedLoads[li], result, shuf, "coalesced");
+            }
+        }
+
+        llvm::CallInst *gather = coalesceGroup[gi];
+        result->takeName(gather);
+        gather->replaceAllUsesWith(result);
+        gather->eraseFromParent();
+    }
+
+    return true;
+}
+
 /** Given an instruction, returns true if the instructon may write to
     memory.  This is a conservative test in that it may return true for
     some instructions that don't actually end up writing to memory, but
@@ -872,15 +997,39 @@ static bool lInstructionMayWriteToMemory(llvm::Instruction *inst) {
     return false;
 }
 
-bool GatherCoalescePass::coalesceGathersFactored(llvm::BasicBlock &bb) {
+bool GatherCoalescePass::coalesceGathers(llvm::BasicBlock &bb) {
     DEBUG_START_BB("GatherCoalescePass");
 
     llvm::Module *M = bb.getModule();
     llvm::Function *gatherFuncs[] = {
+        M->getFunction(builtin::__pseudo_gather_factored_base_offsets32_i8),
+        M->getFunction(builtin::__pseudo_gather_factored_base_offsets32_i16),
+        M->getFunction(builtin::__pseudo_gather_factored_base_offsets32_half),
         M->getFunction(builtin::__pseudo_gather_factored_base_offsets32_i32),
         M->getFunction(builtin::__pseudo_gather_factored_base_offsets32_float),
+        M->getFunction(builtin::__pseudo_gather_factored_base_offsets32_i64),
+        M->getFunction(builtin::__pseudo_gather_factored_base_offsets32_double),
+        M->getFunction(builtin::__pseudo_gather_factored_base_offsets64_i8),
+        M->getFunction(builtin::__pseudo_gather_factored_base_offsets64_i16),
+        M->getFunction(builtin::__pseudo_gather_factored_base_offsets64_half),
         M->getFunction(builtin::__pseudo_gather_factored_base_offsets64_i32),
         M->getFunction(builtin::__pseudo_gather_factored_base_offsets64_float),
+        M->getFunction(builtin::__pseudo_gather_factored_base_offsets64_i64),
+        M->getFunction(builtin::__pseudo_gather_factored_base_offsets64_double),
+        M->getFunction(builtin::__pseudo_gather_base_offsets32_i8),
+        M->getFunction(builtin::__pseudo_gather_base_offsets32_i16),
+        M->getFunction(builtin::__pseudo_gather_base_offsets32_half),
+        M->getFunction(builtin::__pseudo_gather_base_offsets32_i32),
+        M->getFunction(builtin::__pseudo_gather_base_offsets32_float),
+        M->getFunction(builtin::__pseudo_gather_base_offsets32_i64),
+        M->getFunction(builtin::__pseudo_gather_base_offsets32_double),
+        M->getFunction(builtin::__pseudo_gather_base_offsets64_i8),
+        M->getFunction(builtin::__pseudo_gather_base_offsets64_i16),
+        M->getFunction(builtin::__pseudo_gather_base_offsets64_half),
+        M->getFunction(builtin::__pseudo_gather_base_offsets64_i32),
+        M->getFunction(builtin::__pseudo_gather_base_offsets64_float),
+        M->getFunction(builtin::__pseudo_gather_base_offsets64_i64),
+        M->getFunction(builtin::__pseudo_gather_base_offsets64_double),
     };
     int nGatherFuncs = sizeof(gatherFuncs) / sizeof(gatherFuncs[0]);
 
@@ -891,7 +1040,7 @@ bool GatherCoalescePass::coalesceGathersFactored(llvm::BasicBlock &bb) {
     for (llvm::BasicBlock::iterator iter = bb.begin(), e = bb.end(); iter != e;) {
         llvm::BasicBlock::iterator curIter = iter++;
         // Iterate over all of the instructions and look for calls to
-        // __pseudo_gather_factored_base_offsets{32,64}_{i32,float} calls.
+        // __pseudo_gather[_factored]_base_offsets{32,64}_* calls.
         llvm::CallInst *callInst = llvm::dyn_cast<llvm::CallInst>(&*curIter);
         if (callInst == nullptr) {
             continue;
@@ -917,15 +1066,20 @@ bool GatherCoalescePass::coalesceGathersFactored(llvm::BasicBlock &bb) {
         LLVMGetSourcePosFromMetadata(callInst, &pos);
         Debug(pos, "Checking for coalescable gathers starting here...");
 
-        llvm::Value *base = callInst->getArgOperand(0);
-        llvm::Value *variableOffsets = callInst->getArgOperand(1);
-        llvm::Value *offsetScale = callInst->getArgOperand(2);
-        llvm::Value *mask = callInst->getArgOperand(4);
+        CoalescingOperands ops;
+        if (!GetCoalescingOperands(callInst, &ops)) {
+            continue;
+        }
+        llvm::Value *base = ops.base;
+        llvm::Value *variableOffsets = ops.variableOffsets;
+        llvm::Value *offsetScale = ops.scale;
+        llvm::Value *mask = ops.mask;
 
         // To apply this optimization, we need a set of one or more gathers
         // that fulfill the following conditions:
         //
-        // - Mask all on
+        // - Mask not all off; unless it is known at compile time, the
+        //   target must support masked loads (Xe targets are skipped).
         // - The variable offsets to all have the same value (i.e., to be
         //   uniform).
         // - Same base pointer, variable offsets, and offset scale (for
@@ -934,7 +1088,11 @@ bool GatherCoalescePass::coalesceGathersFactored(llvm::BasicBlock &bb) {
         // Then and only then do we have a common base pointer with all
         // offsets from that constants (in which case we can potentially
         // coalesce).
-        if (GetMaskStatusFromValue(mask) != MaskStatus::all_on) {
+        MaskStatus maskStatus = GetMaskStatusFromValue(mask);
+        if (maskStatus == MaskStatus::all_off) {
+            continue;
+        }
+        if (maskStatus == MaskStatus::unknown && g->target->isXeTarget()) {
             continue;
         }
 
@@ -971,31 +1129,36 @@ bool GatherCoalescePass::coalesceGathersFactored(llvm::BasicBlock &bb) {
             // LLVM drops metadata frequently and it results in bad disgnostics.
             LLVMGetSourcePosFromMetadata(fwdCall, &fwdPos);
 
+            CoalescingOperands fwdOps;
+            if (!GetCoalescingOperands(fwdCall, &fwdOps)) {
+                continue;
+            }
+
             if (g->debugPrint) {
-                if (base != fwdCall->getArgOperand(0)) {
+                if (base != fwdOps.base) {
                     Debug(fwdPos, "base pointers mismatch");
                     LLVMDumpValue(base);
-                    LLVMDumpValue(fwdCall->getArgOperand(0));
+                    LLVMDumpValue(fwdOps.base);
                 }
-                if (variableOffsets != fwdCall->getArgOperand(1)) {
+                if (variableOffsets != fwdOps.variableOffsets) {
                     Debug(fwdPos, "varying offsets mismatch");
                     LLVMDumpValue(variableOffsets);
-                    LLVMDumpValue(fwdCall->getArgOperand(1));
+                    LLVMDumpValue(fwdOps.variableOffsets);
                 }
-                if (offsetScale != fwdCall->getArgOperand(2)) {
+                if (offsetScale != fwdOps.scale) {
                     Debug(fwdPos, "offset scales mismatch");
                     LLVMDumpValue(offsetScale);
-                    LLVMDumpValue(fwdCall->getArgOperand(2));
+                    LLVMDumpValue(fwdOps.scale);
                 }
-                if (mask != fwdCall->getArgOperand(4)) {
+                if (mask != fwdOps.mask) {
                     Debug(fwdPos, "masks mismatch");
                     LLVMDumpValue(mask);
-                    LLVMDumpValue(fwdCall->getArgOperand(4));
+                    LLVMDumpValue(fwdOps.mask);
                 }
             }
 
-            if (base == fwdCall->getArgOperand(0) && variableOffsets == fwdCall->getArgOperand(1) &&
-                offsetScale == fwdCall->getArgOperand(2) && mask == fwdCall->getArgOperand(4)) {
+            if (base == fwdOps.base && variableOffsets == fwdOps.variableOffsets && offsetScale == fwdOps.scale &&
+                mask == fwdOps.mask) {
                 Debug(fwdPos, "This gather can be coalesced.");
                 coalesceGroup.push_back(fwdCall);
                 // We deal with a group of instructions handled in a single pass of the optimization.
@@ -1022,8 +1185,12 @@ bool GatherCoalescePass::coalesceGathersFactored(llvm::BasicBlock &bb) {
 
         // Now that we have a group of gathers, see if we can coalesce them
         // into something more efficient than the original set of gathers.
-        if (lCoalesceGathers(coalesceGroup, baseType)) {
-            modifiedAny = true;
+        bool isInt32OrFloat = callInst->getType() == LLVMTypes::Int32VectorType ||
+                              callInst->getType() == LLVMTypes::FloatVectorType;
+        if (isInt32OrFloat && maskStatus == MaskStatus::all_on) {
+            modifiedAny |= lCoalesceGathers(coalesceGroup, baseType);
+        } else {
+            modifiedAny |= lCoalesceGathersGeneric(coalesceGroup, baseType);
         }
     }
     DEBUG_END_BB("GatherCoalescePass");
@@ -1036,7 +1203,7 @@ llvm::PreservedAnalyses GatherCoalescePass::run(llvm::Function &F, llvm::Functio
 
     bool modifiedAny = false;
     for (llvm::BasicBlock &BB : F) {
-        modifiedAny |= coalesceGathersFactored(BB);
+        modifiedAny |= coalesceGathers(BB);
     }
 
     if (!modifiedAny) {
@@ -11,9 +11,9 @@
 namespace ispc {
 
 // This pass implements two optimizations to improve the performance of
-// gathers; currently only gathers of 32-bit values where it can be
-// determined at compile time that the mask is all on are supported, though
-// both of those limitations may be generalized in the future.
+// gathers of 8, 16, 32 and 64-bit values.  When the mask isn't known at
+// compile time, the loads are emitted as masked loads that only access the
+// elements needed by the active lanes.
 //
 //  First, for any single gather, see if it's worthwhile to break it into
 //  any of scalar, 2-wide (i.e. 64-bit), 4-wide, or 8-wide loads.  Further,
@@ -36,8 +36,9 @@ struct GatherCoalescePass : public llvm::PassInfoMixin<GatherCoalescePass> {
   private:
     // Type of base pointer element type (the 1st argument of the intrinsic) is i8
     // e.g. @__pseudo_gather_factored_base_offsets32_i32(i8 *, <WIDTH x i32>, i32, <WIDTH x i32>, <WIDTH x MASK>)
+    // or @__pseudo_gather_base_offsets32_i32(i8 *, i32, <WIDTH x i32>, <WIDTH x MASK>)
     llvm::Type *baseType{LLVMTypes::Int8Type};
-    bool coalesceGathersFactored(llvm::BasicBlock &BB);
+    bool coalesceGathers(llvm::BasicBlock &BB);
 };
 
 } // namespace ispc
@@ -0,0 +1,389 @@
+/*
+  Copyright (c) 2026, Intel Corporation
+
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "GatherScatterVersioning.h"
+#include "builtins-decl.h"
+
+#include <unordered_map>
+
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/Transforms/Utils/ValueMapper.h>
+
+namespace ispc {
+
+/** Description of a pseudo gather or scatter that can be versioned. */
+struct VersionedGSInfo {
+    /** Name of the masked load (for gathers) or masked store (for
+        scatters) function used when the offsets are contiguous. */
+    const char *maskedFunc;
+    /** Size of the elements in bytes. */
+    int elementSize;
+    bool isGather;
+    /** True for the __pseudo_*_factored_base_offsets* functions that take
+        separate varying and constant offsets. */
+    bool isFactored;
+};
+
+static const VersionedGSInfo *lGetVersionedGSInfo(llvm::Function *func) {
+    static std::unordered_map<std::string, VersionedGSInfo> infos = {
+        {__pseudo_gather_base_offsets32_i8, {__masked_load_i8, 1, true, false}},
+        {__pseudo_gather_base_offsets32_i16, {__masked_load_i16, 2, true, false}},
+        {__pseudo_gather_base_offsets32_half, {__masked_load_half, 2, true, false}},
+        {__pseudo_gather_base_offsets32_i32, {__masked_load_i32, 4, true, false}},
+        {__pseudo_gather_base_offsets32_float, {__masked_load_float, 4, true, false}},
+        {__pseudo_gather_base_offsets32_i64, {__masked_load_i64, 8, true, false}},
+        {__pseudo_gather_base_offsets32_double, {__masked_load_double, 8, true, false}},
+        {__pseudo_gather_base_offsets64_i8, {__masked_load_i8, 1, true, false}},
+        {__pseudo_gather_base_offsets64_i16, {__masked_load_i16, 2, true, false}},
+        {__pseudo_gather_base_offsets64_half, {__masked_load_half, 2, true, false}},
+        {__pseudo_gather_base_offsets64_i32, {__masked_load_i32, 4, true, false}},
+        {__pseudo_gather_base_offsets64_float, {__masked_load_float, 4, true, false}},
+        {__pseudo_gather_base_offsets64_i64, {__masked_load_i64, 8, true, false}},
+        {__pseudo_gather_base_offsets64_double, {__masked_load_double, 8, true, false}},
+        {__pseudo_gather_factored_base_offsets32_i8, {__masked_load_i8, 1, true, true}},
+        {__pseudo_gather_factored_base_offsets32_i16, {__masked_load_i16, 2, true, true}},
+        {__pseudo_gather_factored_base_offsets32_half, {__masked_load_half, 2, true, true}},
+        {__pseudo_gather_factored_base_offsets32_i32, {__masked_load_i32, 4, true, true}},
+        {__pseudo_gather_factored_base_offsets32_float, {__masked_load_float, 4, true, true}},
+        {__pseudo_gather_factored_base_offsets32_i64, {__masked_load_i64, 8, true, true}},
+        {__pseudo_gather_factored_base_offsets32_double, {__masked_load_double, 8, true, true}},
+        {__pseudo_gather_factored_base_offsets64_i8, {__masked_load_i8, 1, true, true}},
+        {__pseudo_gather_factored_base_offsets64_i16, {__masked_load_i16, 2, true, true}},
+        {__pseudo_gather_factored_base_offsets64_half, {__masked_load_half, 2, true, true}},
+        {__pseudo_gather_factored_base_offsets64_i32, {__masked_load_i32, 4, true, true}},
+        {__pseudo_gather_factored_base_offsets64_float, {__masked_load_float, 4, true, true}},
+        {__pseudo_gather_factored_base_offsets64_i64, {__masked_load_i64, 8, true, true}},
+        {__pseudo_gather_factored_base_offsets64_double, {__masked_load_double, 8, true, true}},
+        {__pseudo_scatter_base_offsets32_i8, {__pseudo_masked_store_i8, 1, false, false}},
+        {__pseudo_scatter_base_offsets32_i16, {__pseudo_masked_store_i16, 2, false, false}},
+        {__pseudo_scatter_base_offsets32_half, {__pseudo_masked_store_half, 2, false, false}},
+        {__pseudo_scatter_base_offsets32_i32, {__pseudo_masked_store_i32, 4, false, false}},
+        {__pseudo_scatter_base_offsets32_float, {__pseudo_masked_store_float, 4, false, false}},
+        {__pseudo_scatter_base_offsets32_i64, {__pseudo_masked_store_i64, 8, false, false}},
+        {__pseudo_scatter_base_offsets32_double, {__pseudo_masked_store_double, 8, false, false}},
+        {__pseudo_scatter_base_offsets64_i8, {__pseudo_masked_store_i8, 1, false, false}},
+        {__pseudo_scatter_base_offsets64_i16, {__pseudo_masked_store_i16, 2, false, false}},
+        {__pseudo_scatter_base_offsets64_half, {__pseudo_masked_store_half, 2, false, false}},
+        {__pseudo_scatter_base_offsets64_i32, {__pseudo_masked_store_i32, 4, false, false}},
+        {__pseudo_scatter_base_offsets64_float, {__pseudo_masked_store_float, 4, false, false}},
+        {__pseudo_scatter_base_offsets64_i64, {__pseudo_masked_store_i64, 8, false, false}},
+        {__pseudo_scatter_base_offsets64_double, {__pseudo_masked_store_double, 8, false, false}},
+        {__pseudo_scatter_factored_base_offsets32_i8, {__pseudo_masked_store_i8, 1, false, true}},
+        {__pseudo_scatter_factored_base_offsets32_i16, {__pseudo_masked_store_i16, 2, false, true}},
+        {__pseudo_scatter_factored_base_offsets32_half, {__pseudo_masked_store_half, 2, false, true}},
+        {__pseudo_scatter_factored_base_offsets32_i32, {__pseudo_masked_store_i32, 4, false, true}},
+        {__pseudo_scatter_factored_base_offsets32_float, {__pseudo_masked_store_float, 4, false, true}},
+        {__pseudo_scatter_factored_base_offsets32_i64, {__pseudo_masked_store_i64, 8, false, true}},
+        {__pseudo_scatter_factored_base_offsets32_double, {__pseudo_masked_store_double, 8, false, true}},
+        {__pseudo_scatter_factored_base_offsets64_i8, {__pseudo_masked_store_i8, 1, false, true}},
+        {__pseudo_scatter_factored_base_offsets64_i16, {__pseudo_masked_store_i16, 2, false, true}},
+        {__pseudo_scatter_factored_base_offsets64_half, {__pseudo_masked_store_half, 2, false, true}},
+        {__pseudo_scatter_factored_base_offsets64_i32, {__pseudo_masked_store_i32, 4, false, true}},
+        {__pseudo_scatter_factored_base_offsets64_float, {__pseudo_masked_store_float, 4, false, true}},
+        {__pseudo_scatter_factored_base_offsets64_i64, {__pseudo_masked_store_i64, 8, false, true}},
+        {__pseudo_scatter_factored_base_offsets64_double, {__pseudo_masked_store_double, 8, false, true}},
+    };
+
+    if (func == nullptr) {
+        return nullptr;
+    }
+    auto it = infos.find(func->getName().str());
+    return (it != infos.end()) ? &it->second : nullptr;
+}
+
+/** Returns the offsets of a gather or scatter that vary at run time: the
+    varying offsets of the factored forms, or the offsets of the others. */
+static llvm::Value *lGetVaryingOffsets(llvm::CallInst *callInst, const VersionedGSInfo *info) {
+    return callInst->getArgOperand(info->isFactored ? 1 : 2);
+}
+
+/** Emits the computation of the byte offsets from the base pointer that
+    the program instances access with the given gather or scatter. */
+static llvm::Value *lEmitFullOffsets(llvm::CallInst *callInst, const VersionedGSInfo *info,
+                                     llvm::IRBuilder<> &builder) {
+    llvm::Value *offsets = lGetVaryingOffsets(callInst, info);
+    llvm::Value *offsetScale = callInst->getArgOperand(info->isFactored ? 2 : 1);
+    llvm::ConstantInt *offsetScaleInt = llvm::dyn_cast<llvm::ConstantInt>(offsetScale);
+    Assert(offsetScaleInt != nullptr);
+
+    auto *offsetsType = llvm::cast<llvm::FixedVectorType>(offsets->getType());
+    if (!offsetScaleInt->isOne()) {
+        llvm::Constant *scaleVec = llvm::ConstantVector::getSplat(
+            offsetsType->getElementCount(),
+            llvm::ConstantInt::get(offsetsType->getElementType(), offsetScaleInt->getZExtValue()));
+        offsets = builder.CreateMul(offsets, scaleVec, "scaled_offsets");
+    }
+    if (info->isFactored) {
+        offsets = builder.CreateAdd(offsets, callInst->getArgOperand(3), "full_offsets");
+    }
+    return offsets;
+}
+
+/** Returns the vector <0, step, 2*step, ...> of the type of the given
+    offsets. */
+static llvm::Constant *lGetContiguousSteps(llvm::Type *offsetsType, int step) {
+    auto *vecType = llvm::cast<llvm::FixedVectorType>(offsetsType);
+    std::vector<llvm::Constant *> steps;
+    for (unsigned i = 0; i < vecType->getNumElements(); ++i) {
+        steps.push_back(llvm::ConstantInt::get(vecType->getElementType(), (uint64_t)i * step));
+    }
+    return llvm::ConstantVector::get(steps);
+}
+
+/** Maximum number of instructions between the first and the last of a
+    group of gathers and scatters that are versioned together.  The whole
+    range is duplicated for the contiguous version. */
+constexpr int maxVersionedRegionSize = 64;
+
+/** Returns the vector of indices loaded from memory that the given offsets
+    are computed from, e.g. the load of "idx[i]" for "a[idx[i]]", or nullptr
+    if they aren't computed from one with only casts and arithmetic with
+    uniform values.  Versioning only pays off for such offsets: indices
+    stored in memory often come in runs of consecutive values, while offsets
+    computed in the loop are rarely contiguous if they weren't already found
+    to be. */
+static llvm::Value *lGetLoadedIndices(llvm::Value *offsets, int depth = 0) {
+    if (depth > 8) {
+        return nullptr;
+    }
+    if (llvm::isa<llvm::LoadInst>(offsets)) {
+        return offsets;
+    }
+    if (llvm::CallInst *call = llvm::dyn_cast<llvm::CallInst>(offsets)) {
+        llvm::Function *func = call->getCalledFunction();
+        return (func != nullptr && func->getName().starts_with("__masked_load_")) ? offsets : nullptr;
+    }
+    if (llvm::CastInst *cast = llvm::dyn_cast<llvm::CastInst>(offsets)) {
+        return cast->isIntegerCast() ? lGetLoadedIndices(cast->getOperand(0), depth + 1) : nullptr;
+    }
+    llvm::BinaryOperator *binop = llvm::dyn_cast<llvm::BinaryOperator>(offsets);
+    if (binop == nullptr) {
+        return nullptr;
+    }
+    switch (binop->getOpcode()) {
+    case llvm::Instruction::Add:
+    case llvm::Instruction::Sub:
+    case llvm::Instruction::Mul:
+    case llvm::Instruction::Shl:
+        break;
+    default:
+        return nullptr;
+    }
+    for (int i = 0; i < 2; ++i) {
+        llvm::Value *other = binop->getOperand(1 - i);
+        if (llvm::isa<llvm::Constant>(other) || LLVMVectorValuesAllEqual(other)) {
+            return lGetLoadedIndices(binop->getOperand(i), depth + 1);
+        }
+    }
+    return nullptr;
+}
+
+/** Returns true if the given value is available at the given point. */
+static bool lIsAvailableAt(llvm::Value *value, llvm::Instruction *point, const llvm::DominatorTree &DT) {
+    llvm::Instruction *inst = llvm::dyn_cast<llvm::Instruction>(value);
+    return inst == nullptr || DT.dominates(inst, point);
+}
+
+/** Returns the instructions from the first to the last of the given calls,
+    which are in the same block, or an empty vector if there are too many of
+    them or some of them can't be duplicated. */
+static std::vector<llvm::Instruction *> lGetVersionedRegion(const std::vector<llvm::CallInst *> &calls) {
+    std::vector<llvm::Instruction *> region;
+    for (llvm::Instruction *inst = calls.front();; inst = inst->getNextNode()) {
+        llvm::CallBase *call = llvm::dyn_cast<llvm::CallBase>(inst);
+        if ((int)region.size() == maxVersionedRegionSize || llvm::isa<llvm::AllocaInst>(inst) ||
+            inst->getType()->isTokenTy() || (call != nullptr && (call->cannotDuplicate() || call->isConvergent()))) {
+            return {};
+        }
+        region.push_back(inst);
+        if (inst == calls.back()) {
+            return region;
+        }
+    }
+}
+
+/** Splits the block of the given gathers and scatters at a run time check
+    of whether the offsets of all of them are contiguous.  If they are, a
+    copy of the instructions from the first to the last of them is executed,
+    in which they are replaced with masked loads and stores; the original
+    instructions otherwise.  The offsets of all of the calls must be
+    available before the first one.
+ */
+bool GatherScatterVersioningPass::versionGatherScatters(const std::vector<llvm::CallInst *> &calls) {
+    std::vector<llvm::Instruction *> region = lGetVersionedRegion(calls);
+    if (region.empty()) {
+        return false;
+    }
+    std::vector<llvm::Function *> maskedFuncs;
+    bool allGathers = true, allScatters = true;
+    for (llvm::CallInst *callInst : calls) {
+        const VersionedGSInfo *info = lGetVersionedGSInfo(callInst->getCalledFunction());
+        Assert(info != nullptr);
+        maskedFuncs.push_back(callInst->getModule()->getFunction(info->maskedFunc));
+        if (maskedFuncs.back() == nullptr) {
+            return false;
+        }
+        allGathers &= info->isGather;
+        allScatters &= !info->isGather;
+    }
+
+    // Check that offsets[i] == offsets[0] + i * elementSize for all of the
+    // lanes of all of the calls.  The lanes that are off take part in the
+    // check as well; if their offsets don't follow, the gathers and
+    // scatters are used.  Their offsets come from masked loads, so they
+    // may be undef or poison: they are frozen, so that the branch and the
+    // address of the vector load or store are computed from fixed values.
+    // Whatever those are, the active lanes access the addresses they would
+    // with the gather or scatter when the check passes.
+    llvm::IRBuilder<> builder(calls.front());
+    std::vector<llvm::Value *> firstOffsets;
+    llvm::Value *isContiguous = nullptr;
+    for (llvm::CallInst *callInst : calls) {
+        const VersionedGSInfo *info = lGetVersionedGSInfo(callInst->getCalledFunction());
+        llvm::Value *offsets = builder.CreateFreeze(lEmitFullOffsets(callInst, info, builder), "offsets_frozen");
+        llvm::Value *firstOffset = builder.CreateExtractElement(offsets, (uint64_t)0, "first_offset");
+        auto *offsetsType = llvm::cast<llvm::FixedVectorType>(offsets->getType());
+        llvm::Value *contiguousOffsets =
+            builder.CreateAdd(builder.CreateVectorSplat(offsetsType->getNumElements(), firstOffset),
+                              lGetContiguousSteps(offsetsType, info->elementSize), "contiguous_offsets");
+        llvm::Value *matches =
+            builder.CreateAndReduce(builder.CreateICmpEQ(offsets, contiguousOffsets, "offsets_match"));
+        isContiguous = (isContiguous == nullptr) ? matches : builder.CreateAnd(isContiguous, matches);
+        firstOffsets.push_back(firstOffset);
+    }
+
+    llvm::Instruction *thenTerm = nullptr;
+    llvm::Instruction *elseTerm = nullptr;
+    llvm::SplitBlockAndInsertIfThenElse(isContiguous, calls.front(), &thenTerm, &elseTerm);
+    llvm::BasicBlock *contiguousBB = thenTerm->getParent();
+    llvm::BasicBlock *gatherScatterBB = elseTerm->getParent();
+    llvm::BasicBlock *joinBB = calls.back()->getParent();
+    const char *kind = allGathers ? "gather" : (allScatters ? "scatter" : "gather_scatter");
+    contiguousBB->setName(llvm::Twine(kind) + "_contiguous");
+    gatherScatterBB->setName(llvm::Twine(kind) + "_general");
+
+    // Move the region to the general version and copy it to the contiguous
+    // one.
+    llvm::ValueToValueMapTy vmap;
+    for (llvm::Instruction *inst : region) {
+        llvm::Instruction *copy = inst->clone();
+        copy->setName(inst->getName());
+        copy->insertBefore(ISPC_INSERTION_POINT_INSTRUCTION(thenTerm));
+        llvm::RemapInstruction(copy, vmap, llvm::RF_NoModuleLevelChanges | llvm::RF_IgnoreMissingLocals);
+        vmap[inst] = copy;
+        inst->removeFromParent();
+        inst->insertBefore(ISPC_INSERTION_POINT_INSTRUCTION(elseTerm));
+    }
+
+    // Merge the values of the two versions that are used after the region.
+    builder.SetInsertPoint(joinBB, joinBB->begin());
+    for (llvm::Instruction *inst : region) {
+        if (inst->getType()->isVoidTy() || inst->use_empty()) {
+            continue;
+        }
+        llvm::PHINode *phi = builder.CreatePHI(inst->getType(), 2, inst->getName() + "_versioned");
+        inst->replaceUsesWithIf(phi, [&](llvm::Use &use) {
+            return llvm::cast<llvm::Instruction>(use.getUser())->getParent() != gatherScatterBB;
+        });
+        if (phi->use_empty()) {
+            phi->eraseFromParent();
+            continue;
+        }
+        phi->addIncoming(vmap[inst], contiguousBB);
+        phi->addIncoming(inst, gatherScatterBB);
+    }
+
+    // Replace the gathers and scatters of the contiguous version with
+    // masked loads and stores.
+    for (size_t i = 0; i < calls.size(); ++i) {
+        const VersionedGSInfo *info = lGetVersionedGSInfo(calls[i]->getCalledFunction());
+        llvm::CallInst *copy = llvm::cast<llvm::CallInst>(vmap[calls[i]]);
+        llvm::Value *mask = copy->getArgOperand(copy->arg_size() - 1);
+        builder.SetInsertPoint(copy);
+        llvm::Value *ptr = builder.CreateGEP(LLVMTypes::Int8Type, copy->getArgOperand(0), firstOffsets[i],
+                                             "contiguous_ptr");
+        llvm::CallInst *maskedCall = nullptr;
+        if (info->isGather) {
+            maskedCall = builder.CreateCall(maskedFuncs[i], {ptr, mask}, calls[i]->getName() + "_contiguous");
+        } else {
+            llvm::Value *storeValue = copy->getArgOperand(copy->arg_size() - 2);
+            maskedCall = builder.CreateCall(maskedFuncs[i], {ptr, storeValue, mask});
+        }
+        LLVMCopyMetadata(maskedCall, calls[i]);
+        copy->replaceAllUsesWith(maskedCall);
+        copy->eraseFromParent();
+    }
+
+    SourcePos pos;
+    LLVMGetSourcePosFromMetadata(calls.front(), &pos);
+    Debug(pos, "Versioned %d gathers and scatters on a run time check for contiguous offsets.", (int)calls.size());
+    return true;
+}
+
+llvm::PreservedAnalyses GatherScatterVersioningPass::run(llvm::Function &F, llvm::FunctionAnalysisManager &FAM) {
+    llvm::TimeTraceScope FuncScope("GatherScatterVersioningPass::run", F.getName());
+    if (g->target->isXeTarget() || g->target->getVectorWidth() == 1) {
+        return llvm::PreservedAnalyses::all();
+    }
+
+    // Collect the groups of gathers and scatters first, since versioning
+    // them splits their blocks.  The consecutive candidates of a block that
+    // use the same loaded indices share one check, as long as their offsets
+    // are available before the first of them.
+    llvm::LoopInfo &LI = FAM.getResult<llvm::LoopAnalysis>(F);
+    llvm::DominatorTree &DT = FAM.getResult<llvm::DominatorTreeAnalysis>(F);
+    std::vector<std::vector<llvm::CallInst *>> groups;
+    for (llvm::BasicBlock &BB : F) {
+        llvm::Loop *L = LI.getLoopFor(&BB);
+        if (L == nullptr || !L->isInnermost()) {
+            continue;
+        }
+        llvm::Value *groupIndices = nullptr;
+        for (llvm::Instruction &inst : BB) {
+            llvm::CallInst *callInst = llvm::dyn_cast<llvm::CallInst>(&inst);
+            const VersionedGSInfo *info =
+                (callInst != nullptr) ? lGetVersionedGSInfo(callInst->getCalledFunction()) : nullptr;
+            if (info == nullptr) {
+                continue;
+            }
+            // Offsets known at compile time and offsets that are the same
+            // in all of the lanes are handled by ImproveMemoryOpsPass.
+            llvm::Value *offsets = lGetVaryingOffsets(callInst, info);
+            if (llvm::isa<llvm::Constant>(offsets) || LLVMVectorValuesAllEqual(offsets)) {
+                continue;
+            }
+            llvm::Value *mask = callInst->getArgOperand(callInst->arg_size() - 1);
+            if (GetMaskStatusFromValue(mask) == MaskStatus::all_off) {
+                continue;
+            }
+            llvm::Value *indices = lGetLoadedIndices(offsets);
+            if (indices == nullptr) {
+                continue;
+            }
+            llvm::Instruction *groupStart = (groupIndices == indices) ? groups.back().front() : nullptr;
+            if (groupStart != nullptr && lIsAvailableAt(offsets, groupStart, DT) &&
+                (!info->isFactored || lIsAvailableAt(callInst->getArgOperand(3), groupStart, DT))) {
+                groups.back().push_back(callInst);
+            } else {
+                groups.push_back({callInst});
+                groupIndices = indices;
+            }
+        }
+    }
+
+    bool modifiedAny = false;
+    for (const std::vector<llvm::CallInst *> &group : groups) {
+        modifiedAny |= versionGatherScatters(group);
+    }
+
+    if (!modifiedAny) {
+        return llvm::PreservedAnalyses::all();
+    }
+    return llvm::PreservedAnalyses::none();
+}
+
+} // namespace ispc
@@ -0,0 +1,44 @@
+/*
+  Copyright (c) 2026, Intel Corporation
+
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#include "ISPCPass.h"
+
+#include <llvm/Analysis/LoopInfo.h>
+
+namespace ispc {
+
+/** Gathers and scatters whose offsets are computed at run time from
+    indices loaded from memory, as in "a[idx[i]]", stay gathers and scatters
+    even when the indices mostly come in runs of consecutive values, as is
+    typical for sparse data.  For such gathers and scatters in innermost
+    loops, this pass checks at run time whether the offsets of all of the
+    program instances are contiguous and, if so, branches to a version of
+    the loop body where they are vector loads and stores.  The original
+    gathers and scatters are kept for the other case.
+
+    Gathers and scatters with offsets computed in some other way aren't
+    versioned, since their offsets are rarely contiguous.  The consecutive
+    ones of a block that use the same indices, like the reads of "a[idx[i]]"
+    and "b[idx[i]]", share one check: the instructions from the first to the
+    last of them are duplicated for the two versions.
+
+    The vector loads and stores use the masks of the gathers and scatters,
+    so they become unmasked ones when the mask is all on.
+ */
+class GatherScatterVersioningPass : public llvm::PassInfoMixin<GatherScatterVersioningPass> {
+  public:
+    explicit GatherScatterVersioningPass() {}
+
+    static llvm::StringRef getPassName() { return "Version gathers and scatters on contiguous offsets"; }
+    llvm::PreservedAnalyses run(llvm::Function &F, llvm::FunctionAnalysisManager &FAM);
+
+  private:
+    bool versionGatherScatters(const std::vector<llvm::CallInst *> &calls);
+};
+
+} // namespace ispc
@@ -12,6 +12,7 @@
 
 #include "CheckIRForXeTarget.h"
 #include "GatherCoalescePass.h"
+#include "GatherScatterVersioning.h"
 #include "ImproveMemoryOps.h"
 #include "InstructionSimplify.h"
 #include "IntrinsicsOptPass.h"
@@ -25,5 +26,7 @@
 #include "ReplacePseudoMemoryOps.h"
 #include "ReplaceStdlibShiftPass.h"
 #include "ScalarizePass.h"
+#include "ScatterCoalescePass.h"
+#include "SpecializeUniformArgs.h"
 #include "XeGatherCoalescePass.h"
 #include "XeReplaceLLVMIntrinsics.h"
@@ -1563,6 +1563,276 @@ static llvm::Instruction *lGSToLoadStore(llvm::CallInst *callInst) {
     }
 }
 
+/** Strips additions of constant splats from the given vector of integers,
+    returning the remaining value and the sum of the splatted values in
+    *splat.  No instructions are created, so that the results for two
+    vectors that only differ in these constants can be compared.
+ */
+static llvm::Value *lStripSplatAdds(llvm::Value *v, int64_t *splat) {
+    *splat = 0;
+    while (true) {
+        llvm::BinaryOperator *bop = llvm::dyn_cast<llvm::BinaryOperator>(v);
+        if (bop == nullptr || (bop->getOpcode() != llvm::Instruction::Add && !IsOrEquivalentToAdd(bop))) {
+            return v;
+        }
+        int value = 0;
+        if (lIsIntegerSplat(bop->getOperand(1), &value)) {
+            v = bop->getOperand(0);
+        } else if (lIsIntegerSplat(bop->getOperand(0), &value)) {
+            v = bop->getOperand(1);
+        } else {
+            return v;
+        }
+        *splat += value;
+    }
+}
+
+/** The addresses read by a gather with a constant stride between the
+    program instances, decomposed as base + scale * variable[0] + offset +
+    lane * stride, where "variable" is nullptr if there is no such term.
+    Gathers that read different fields of the same structures only differ
+    in "offset".
+ */
+struct StridedGather {
+    llvm::CallInst *call;
+    llvm::Value *variable;
+    int64_t offset;
+};
+
+/** Checks if the given call to a __pseudo_gather*_base_offsets* function
+    reads addresses with a constant stride of the given number of bytes
+    between the program instances, and decomposes them as described for
+    StridedGather.
+ */
+static bool lGetStridedGather(llvm::CallInst *callInst, bool isFactored, int stride, StridedGather *info) {
+    const int width = g->target->getVectorWidth();
+    std::vector<int64_t> offsets(width);
+    int nElts = 0;
+    info->call = callInst;
+
+    if (isFactored) {
+        // offsetScale * varyingOffsets + constOffsets, with the varying
+        // offsets having the same value in all of the program instances.
+        llvm::Value *varyingOffsets = callInst->getArgOperand(1);
+        llvm::Value *constOffsets = callInst->getArgOperand(3);
+        if (!LLVMVectorValuesAllEqual(varyingOffsets) || !LLVMExtractVectorInts(constOffsets, &offsets[0], &nElts)) {
+            return false;
+        }
+        for (int i = 1; i < nElts; ++i) {
+            if (offsets[i] - offsets[i - 1] != stride) {
+                return false;
+            }
+        }
+        info->variable = varyingOffsets;
+        info->offset = offsets[0];
+        return true;
+    }
+
+    // offsetScale * offsets, with the offsets being linear.
+    llvm::ConstantInt *offsetScale = llvm::dyn_cast<llvm::ConstantInt>(callInst->getArgOperand(1));
+    if (offsetScale == nullptr) {
+        return false;
+    }
+    int64_t scale = offsetScale->getSExtValue();
+    llvm::Value *vec = callInst->getArgOperand(2);
+    if (scale <= 0 || stride % scale != 0 || !LLVMVectorIsLinear(vec, (int)(stride / scale))) {
+        return false;
+    }
+    int64_t splat = 0;
+    llvm::Value *variable = lStripSplatAdds(vec, &splat);
+    if (llvm::isa<llvm::Constant>(variable)) {
+        if (!LLVMExtractVectorInts(variable, &offsets[0], &nElts)) {
+            return false;
+        }
+        info->variable = nullptr;
+        info->offset = scale * (splat + offsets[0]);
+    } else {
+        info->variable = variable;
+        info->offset = scale * splat;
+    }
+    return true;
+}
+
+/** Gathers that read several fields of an array of small structures, like
+    pts[programIndex + base].x and pts[programIndex + base].y, read
+    addresses with a stride of the size of the structure, which is 2, 3 or
+    4 times the size of the fields.  This replaces such a group of gathers
+    with vector loads of the memory they read, and shuffles that pick the
+    fields out of the loaded values, as aos_to_soa3() and aos_to_soa4() do
+    in the standard library.
+
+    Only the memory between the first and the last address read by the
+    gathers is loaded, so this only applies to groups of at least two
+    gathers with the mask all on and no writes to memory in between; the
+    siblings of the given gather are erased, moving "iter" past them.
+ */
+static llvm::Value *lGSToInterleavedLoads(llvm::CallInst *callInst, llvm::BasicBlock::iterator &iter) {
+    llvm::Function *calledFunc = callInst->getCalledFunction();
+    llvm::StringRef name = calledFunc->getName();
+    bool isFactored = name.starts_with("__pseudo_gather_factored_base_offsets");
+    if (!isFactored && !name.starts_with("__pseudo_gather_base_offsets")) {
+        return nullptr;
+    }
+    if (g->target->isXeTarget()) {
+        return nullptr;
+    }
+
+    llvm::Value *base = callInst->getArgOperand(0);
+    llvm::Value *offsetScale = callInst->getArgOperand(isFactored ? 2 : 1);
+    llvm::Value *mask = callInst->getArgOperand(isFactored ? 4 : 3);
+    if (GetMaskStatusFromValue(mask) != MaskStatus::all_on) {
+        return nullptr;
+    }
+
+    auto *resultType = llvm::cast<llvm::FixedVectorType>(callInst->getType());
+    llvm::Type *elementType = resultType->getElementType();
+    const int width = resultType->getNumElements();
+    const int elementSize = g->target->getDataLayout()->getTypeStoreSize(elementType);
+
+    for (int nFields = 2; nFields <= 4; ++nFields) {
+        const int stride = nFields * elementSize;
+        std::vector<StridedGather> group(1);
+        if (!lGetStridedGather(callInst, isFactored, stride, &group[0])) {
+            continue;
+        }
+
+        // Look for gathers of the other fields of the same structures in
+        // the rest of the basic block, up to the first write to memory.
+        for (llvm::BasicBlock::iterator fwdIter = std::next(callInst->getIterator());
+             fwdIter != callInst->getParent()->end() && !fwdIter->mayWriteToMemory(); ++fwdIter) {
+            llvm::CallInst *fwdCall = llvm::dyn_cast<llvm::CallInst>(&*fwdIter);
+            StridedGather sibling;
+            if (fwdCall == nullptr || fwdCall->getCalledFunction() != calledFunc ||
+                fwdCall->getArgOperand(0) != base || fwdCall->getArgOperand(isFactored ? 2 : 1) != offsetScale ||
+                fwdCall->getArgOperand(isFactored ? 4 : 3) != mask ||
+                !lGetStridedGather(fwdCall, isFactored, stride, &sibling) ||
+                sibling.variable != group[0].variable || (sibling.offset - group[0].offset) % elementSize != 0) {
+                continue;
+            }
+            group.push_back(sibling);
+            if ((int)group.size() == nFields) {
+                break;
+            }
+        }
+        if (group.size() < 2) {
+            continue;
+        }
+
+        int64_t minOffset = group[0].offset, maxOffset = group[0].offset;
+        for (const StridedGather &gather : group) {
+            minOffset = std::min(minOffset, gather.offset);
+            maxOffset = std::max(maxOffset, gather.offset);
+        }
+        if (maxOffset - minOffset >= stride) {
+            // Not fields of the same structures.
+            continue;
+        }
+
+        SourcePos pos;
+        LLVMGetSourcePosFromMetadata(callInst, &pos);
+        Debug(pos, "Transformed %d gathers with stride %d to vector loads and shuffles!", (int)group.size(), stride);
+
+        // Compute the address of the first element to load.
+        llvm::Value *ptr = base;
+        if (group[0].variable != nullptr) {
+            llvm::Value *variable = llvm::ExtractElementInst::Create(group[0].variable, LLVMInt32(0), "variable",
+                                                                     ISPC_INSERTION_POINT_INSTRUCTION(callInst));
+            if (variable->getType() == LLVMTypes::Int64Type) {
+                offsetScale = new llvm::ZExtInst(offsetScale, LLVMTypes::Int64Type, "scale_to64",
+                                                 ISPC_INSERTION_POINT_INSTRUCTION(callInst));
+            }
+            llvm::Value *offset = llvm::BinaryOperator::Create(llvm::Instruction::Mul, variable, offsetScale,
+                                                               "offset", ISPC_INSERTION_POINT_INSTRUCTION(callInst));
+            ptr = LLVMGEPInst(ptr, LLVMTypes::Int8Type, offset, "aos_base", callInst);
+        }
+        ptr = LLVMGEPInst(ptr, LLVMTypes::Int8Type, LLVMInt64(minOffset), "aos_base", callInst);
+
+        // Load the elements with vectors of the gather width, and smaller
+        // powers of two for the rest, widening them to the gather width.
+        const int nElements = (width - 1) * nFields + (int)((maxOffset - minOffset) / elementSize) + 1;
+        std::vector<std::pair<int, llvm::Value *>> loads;
+        for (int start = 0; start < nElements;) {
+            int count = width;
+            while (count > nElements - start) {
+                count /= 2;
+            }
+            llvm::Value *loadPtr = LLVMGEPInst(ptr, LLVMTypes::Int8Type, LLVMInt64(start * elementSize), "aos_ptr",
+                                               callInst);
+            llvm::Value *load = new llvm::LoadInst(llvm::FixedVectorType::get(elementType, count), loadPtr, "aos_load",
+                                                   false, llvm::Align(elementSize),
+                                                   ISPC_INSERTION_POINT_INSTRUCTION(callInst));
+            if (count < width) {
+                llvm::SmallVector<int, ISPC_MAX_NVEC> widen(width, -1);
+                for (int i = 0; i < count; ++i) {
+                    widen[i] = i;
+                }
+                load = new llvm::ShuffleVectorInst(load, llvm::PoisonValue::get(load->getType()), widen, "aos_load",
+                                                   ISPC_INSERTION_POINT_INSTRUCTION(callInst));
+            }
+            loads.push_back(std::make_pair(start, load));
+            start += count;
+        }
+
+        // Report the group the same way as GatherCoalescePass does, which
+        // would otherwise have coalesced it.
+        if (g->opt.level > 0) {
+            std::string otherPositions;
+            for (int i = 1; i < (int)group.size(); ++i) {
+                SourcePos p;
+                if (LLVMGetSourcePosFromMetadata(group[i].call, &p)) {
+                    otherPositions += (otherPositions.empty() ? "" : ", ") + std::to_string(p.first_line);
+                }
+            }
+            if (!otherPositions.empty()) {
+                const char *plural = (group.size() > 2) ? "s" : "";
+                otherPositions = std::string("(other") + plural + " at line" + plural + " " + otherPositions + ") ";
+            }
+            PerformanceWarning(pos, "Coalesced %d gathers starting here %sinto %d load%s and shuffles.",
+                               (int)group.size(), otherPositions.c_str(), (int)loads.size(),
+                               (loads.size() > 1) ? "s" : "");
+        }
+
+        // Pick the elements read by each of the gathers out of the loads.
+        std::vector<llvm::Value *> results;
+        for (const StridedGather &gather : group) {
+            int field = (int)((gather.offset - minOffset) / elementSize);
+            llvm::Value *result = llvm::UndefValue::get(resultType);
+            for (int li = 0; li < (int)loads.size(); ++li) {
+                int start = loads[li].first;
+                int end = (li + 1 < (int)loads.size()) ? loads[li + 1].first : nElements;
+                llvm::SmallVector<int, ISPC_MAX_NVEC> shuf(width);
+                bool anyMatched = false;
+                for (int lane = 0; lane < width; ++lane) {
+                    int element = field + lane * nFields;
+                    shuf[lane] = width + lane;
+                    if (element >= start && element < end) {
+                        shuf[lane] = element - start;
+                        anyMatched = true;
+                    }
+                }
+                if (anyMatched) {
+                    result = new llvm::ShuffleVectorInst(loads[li].second, result, shuf, "aos_field",
+                                                         ISPC_INSERTION_POINT_INSTRUCTION(callInst));
+                }
+            }
+            LLVMCopyMetadata(result, gather.call);
+            results.push_back(result);
+        }
+
+        for (int i = (int)group.size() - 1; i >= 0; --i) {
+            llvm::CallInst *gather = group[i].call;
+            if (i > 0 && iter != callInst->getParent()->end() && &*iter == gather) {
+                ++iter;
+            }
+            results[i]->takeName(gather);
+            gather->replaceAllUsesWith(results[i]);
+            gather->eraseFromParent();
+        }
+        return results[0];
+    }
+    return nullptr;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // MaskedStoreOptPass
 
@@ -1721,6 +1991,8 @@ bool ImproveMemoryOpsPass::improveMemoryOps(llvm::BasicBlock &bb) {
                 modifiedAny = true;
             } else if ((newValue = lGSToLoadStore(callInst))) {
                 modifiedAny = true;
+            } else if ((newValue = lGSToInterleavedLoads(callInst, iter))) {
+                modifiedAny = true;
             } else if ((newValue = lImproveMaskedStore(callInst))) {
                 modifiedAny = true;
             } else if ((newValue = lImproveMaskedLoad(callInst, curIter))) {
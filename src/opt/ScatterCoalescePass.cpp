@@ -0,0 +1,352 @@
+/*
+  Copyright (c) 2026, Intel Corporation
+
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "ScatterCoalescePass.h"
+#include "CoalesceUtils.h"
+#include "builtins-decl.h"
+
+#include <algorithm>
+#include <map>
+
+#include <llvm/Analysis/MemoryLocation.h>
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/IRBuilder.h>
+
+namespace ispc {
+
+/** Representation of a vector store that the scatter coalescing code has
+    decided to generate.
+ */
+struct CoalescedStoreOp {
+    CoalescedStoreOp(int64_t s, int c) : start(s), count(c) {}
+
+    /** Starting offset of the store from the common base pointer (in terms
+        of numbers of items of the underlying element type--*not* in terms
+        of bytes). */
+    int64_t start;
+
+    /** Number of elements to store at this location */
+    int count;
+};
+
+/** The lane of one of the scatters of a group that provides the value that
+    ends up in memory at some offset. */
+struct ScatterLane {
+    int scatter;
+    int lane;
+};
+
+/** Covers the elements that are written by the scatters with stores:
+    each run of consecutive elements is split into the widest vector
+    stores of up to maxWidth elements that fit in it, and single elements
+    that remain are stored with scalar (1-wide) stores.
+ */
+static void lSelectStores(const std::map<int64_t, ScatterLane> &writers, int maxWidth,
+                          std::vector<CoalescedStoreOp> *stores) {
+    std::map<int64_t, ScatterLane>::const_iterator iter = writers.begin();
+    while (iter != writers.end()) {
+        int64_t start = iter->first;
+        int runLength = 0;
+        while (iter != writers.end() && iter->first == start + runLength) {
+            ++iter;
+            ++runLength;
+        }
+
+        while (runLength > 0) {
+            int count = maxWidth;
+            while (count > runLength) {
+                count /= 2;
+            }
+            stores->push_back(CoalescedStoreOp(start, count));
+            start += count;
+            runLength -= count;
+        }
+    }
+}
+
+/** Issue a performance warning with a summary of the stores that a group
+    of scatters were coalesced into. */
+static void lCoalescePerfInfo(const std::vector<llvm::CallInst *> &coalesceGroup,
+                              const std::vector<CoalescedStoreOp> &storeOps) {
+    SourcePos pos;
+    LLVMGetSourcePosFromMetadata(coalesceGroup[0], &pos);
+
+    // Count how many stores of each size there were.
+    std::map<int, int> storeOpsCount;
+    for (const CoalescedStoreOp &store : storeOps) {
+        ++storeOpsCount[store.count];
+    }
+
+    std::string storeOpsInfo;
+    for (std::map<int, int>::const_iterator iter = storeOpsCount.begin(); iter != storeOpsCount.end(); ++iter) {
+        if (!storeOpsInfo.empty()) {
+            storeOpsInfo += ", ";
+        }
+        storeOpsInfo += std::to_string(iter->second) + " x " + std::to_string(iter->first) + "-wide";
+    }
+
+    if (g->opt.level > 0) {
+        PerformanceWarning(pos, "Coalesced %d scatter%s starting here into %d store%s (%s).",
+                           (int)coalesceGroup.size(), (coalesceGroup.size() > 1) ? "s" : "", (int)storeOps.size(),
+                           (storeOps.size() > 1) ? "s" : "", storeOpsInfo.c_str());
+    }
+}
+
+/** Actually do the coalescing.  We have a set of scatters all writing to
+    addresses of the form:
+
+    (ptr + {1,2,4,8} * varyingOffset) + constOffset, a.k.a.
+    basePtr + constOffset
+
+    where varyingOffset has the same value across all of the SIMD lanes and
+    where the part in parenthesis has the same value for all of the
+    scatters in the group.  The stores replacing them are emitted where the
+    last scatter of the group is, as the values of the later scatters may
+    be computed after the first one.
+ */
+static bool lCoalesceScatters(const std::vector<llvm::CallInst *> &coalesceGroup, llvm::Type *baseType) {
+    llvm::CallInst *firstScatter = coalesceGroup[0];
+    llvm::CallInst *lastScatter = coalesceGroup.back();
+    auto *valueType = llvm::cast<llvm::FixedVectorType>(firstScatter->getArgOperand(4)->getType());
+    llvm::Type *elementType = valueType->getElementType();
+    const int width = valueType->getNumElements();
+    const llvm::DataLayout *dl = g->target->getDataLayout();
+    const int elementSize = dl->getTypeStoreSize(elementType);
+    const llvm::Align align = dl->getABITypeAlign(elementType);
+
+    std::vector<int64_t> constOffsets;
+    if (!ExtractCoalescedConstOffsets(coalesceGroup, elementSize, &constOffsets)) {
+        return false;
+    }
+
+    CoalescingOperands ops;
+    bool ok = GetCoalescingOperands(firstScatter, &ops);
+    Assert(ok);
+
+    // For each element written, find the lane whose value ends up in
+    // memory: the one of the last scatter, and the last lane of it, that
+    // write to the element.  Lanes known to be off don't write anything.
+    llvm::Value *mask = ops.mask;
+    uint64_t maskBits = 0;
+    const bool maskIsKnown = GetMaskFromValue(mask, &maskBits);
+    std::map<int64_t, ScatterLane> writers;
+    for (int si = 0; si < (int)coalesceGroup.size(); ++si) {
+        for (int lane = 0; lane < width; ++lane) {
+            if (maskIsKnown && (maskBits & (1ull << lane)) == 0) {
+                continue;
+            }
+            int64_t offset = constOffsets[si * width + lane];
+            if (!maskIsKnown && writers.find(offset) != writers.end()) {
+                // Which of the lanes writes the value that ends up in
+                // memory depends on the mask at run time.
+                return false;
+            }
+            writers[offset] = ScatterLane{si, lane};
+        }
+    }
+    if (writers.empty()) {
+        return false;
+    }
+
+    int maxWidth = 1;
+    while (maxWidth * 2 <= width && maxWidth * 2 * elementSize <= 64) {
+        maxWidth *= 2;
+    }
+    std::vector<CoalescedStoreOp> storeOps;
+    lSelectStores(writers, maxWidth, &storeOps);
+
+    // Scalar stores aren't any better than the original scatters.
+    bool anyVectorStore = false;
+    for (const CoalescedStoreOp &store : storeOps) {
+        anyVectorStore |= store.count > 1;
+    }
+    if (!anyVectorStore) {
+        return false;
+    }
+
+    lCoalescePerfInfo(coalesceGroup, storeOps);
+
+    llvm::Value *basePtr = ComputeCoalescedBasePtr(ops, baseType, lastScatter);
+    llvm::IRBuilder<> builder(lastScatter);
+    llvm::Value *laneMask = nullptr;
+    if (!maskIsKnown) {
+        auto *maskType = llvm::cast<llvm::FixedVectorType>(mask->getType());
+        laneMask = maskType->getElementType()->isIntegerTy(1)
+                       ? mask
+                       : builder.CreateICmpNE(mask, llvm::Constant::getNullValue(maskType), "mask_i1");
+    }
+
+    for (const CoalescedStoreOp &store : storeOps) {
+        // Shuffle the values of each of the scatters into the elements of
+        // the store they write, and select them into the stored value.
+        llvm::Value *value = nullptr;
+        for (int si = 0; si < (int)coalesceGroup.size(); ++si) {
+            llvm::SmallVector<int, 16> extract(store.count, -1), select(store.count);
+            bool contributes = false;
+            for (int j = 0; j < store.count; ++j) {
+                const ScatterLane &writer = writers.at(store.start + j);
+                select[j] = j;
+                if (writer.scatter == si) {
+                    extract[j] = writer.lane;
+                    select[j] = store.count + j;
+                    contributes = true;
+                }
+            }
+            if (!contributes) {
+                continue;
+            }
+            llvm::Value *values =
+                builder.CreateShuffleVector(coalesceGroup[si]->getArgOperand(4), extract, "scatter_values");
+            value = value ? builder.CreateShuffleVector(value, values, select, "scatter_values") : values;
+        }
+
+        llvm::Value *ptr =
+            LLVMGEPInst(basePtr, baseType, LLVMInt64(store.start * elementSize), "new_base", lastScatter);
+        if (laneMask != nullptr) {
+            llvm::SmallVector<int, 16> lanes(store.count);
+            for (int j = 0; j < store.count; ++j) {
+                lanes[j] = writers.at(store.start + j).lane;
+            }
+            llvm::Value *storeMask = builder.CreateShuffleVector(laneMask, lanes, "store_mask");
+            builder.CreateMaskedStore(value, ptr, align, storeMask);
+        } else {
+            builder.CreateAlignedStore(value, ptr, align);
+        }
+    }
+
+    for (llvm::CallInst *scatter : coalesceGroup) {
+        scatter->eraseFromParent();
+    }
+    return true;
+}
+
+bool ScatterCoalescePass::coalesceScattersFactored(llvm::BasicBlock &bb, llvm::AAResults &AA) {
+    DEBUG_START_BB("ScatterCoalescePass");
+
+    llvm::Module *M = bb.getModule();
+    llvm::Function *scatterFuncs[] = {
+        M->getFunction(builtin::__pseudo_scatter_factored_base_offsets32_i8),
+        M->getFunction(builtin::__pseudo_scatter_factored_base_offsets32_i16),
+        M->getFunction(builtin::__pseudo_scatter_factored_base_offsets32_half),
+        M->getFunction(builtin::__pseudo_scatter_factored_base_offsets32_i32),
+        M->getFunction(builtin::__pseudo_scatter_factored_base_offsets32_float),
+        M->getFunction(builtin::__pseudo_scatter_factored_base_offsets32_i64),
+        M->getFunction(builtin::__pseudo_scatter_factored_base_offsets32_double),
+        M->getFunction(builtin::__pseudo_scatter_factored_base_offsets64_i8),
+        M->getFunction(builtin::__pseudo_scatter_factored_base_offsets64_i16),
+        M->getFunction(builtin::__pseudo_scatter_factored_base_offsets64_half),
+        M->getFunction(builtin::__pseudo_scatter_factored_base_offsets64_i32),
+        M->getFunction(builtin::__pseudo_scatter_factored_base_offsets64_float),
+        M->getFunction(builtin::__pseudo_scatter_factored_base_offsets64_i64),
+        M->getFunction(builtin::__pseudo_scatter_factored_base_offsets64_double),
+    };
+    int nScatterFuncs = sizeof(scatterFuncs) / sizeof(scatterFuncs[0]);
+
+    bool modifiedAny = false;
+
+    // Note: we do modify instruction list during the traversal, so the iterator
+    // is moved forward before the instruction is processed.
+    for (llvm::BasicBlock::iterator iter = bb.begin(), e = bb.end(); iter != e;) {
+        llvm::BasicBlock::iterator curIter = iter++;
+        llvm::CallInst *callInst = llvm::dyn_cast<llvm::CallInst>(&*curIter);
+        if (callInst == nullptr || callInst->getCalledFunction() == nullptr) {
+            continue;
+        }
+
+        llvm::Function *calledFunc = callInst->getCalledFunction();
+        if (std::find(scatterFuncs, scatterFuncs + nScatterFuncs, calledFunc) == scatterFuncs + nScatterFuncs) {
+            continue;
+        }
+
+        SourcePos pos;
+        LLVMGetSourcePosFromMetadata(callInst, &pos);
+        Debug(pos, "Checking for coalescable scatters starting here...");
+
+        llvm::Value *base = callInst->getArgOperand(0);
+        llvm::Value *variableOffsets = callInst->getArgOperand(1);
+        llvm::Value *offsetScale = callInst->getArgOperand(2);
+        llvm::Value *mask = callInst->getArgOperand(5);
+
+        // As for gathers, the scatters of a group need the same base
+        // pointer, varying offsets with the same value in all of the lanes,
+        // offset scale and mask.  Masks unknown at compile time need masked
+        // stores, which Xe targets don't get here.
+        MaskStatus maskStatus = GetMaskStatusFromValue(mask);
+        if (maskStatus == MaskStatus::all_off || (maskStatus == MaskStatus::unknown && g->target->isXeTarget())) {
+            continue;
+        }
+        if (!LLVMVectorValuesAllEqual(variableOffsets)) {
+            continue;
+        }
+
+        std::vector<llvm::CallInst *> coalesceGroup;
+        coalesceGroup.push_back(callInst);
+
+        // The stores replacing the group are emitted at the last scatter of
+        // it, so the instructions in between must not access the memory
+        // written by the scatters, and must pass the execution on.
+        const llvm::MemoryLocation scatterLoc = llvm::MemoryLocation::getBeforeOrAfter(base);
+        llvm::BasicBlock::iterator fwdIter = curIter;
+        ++fwdIter;
+        for (; fwdIter != bb.end(); ++fwdIter) {
+            llvm::CallInst *fwdCall = llvm::dyn_cast<llvm::CallInst>(&*fwdIter);
+            if (fwdCall != nullptr && fwdCall->getCalledFunction() == calledFunc && base == fwdCall->getArgOperand(0) &&
+                variableOffsets == fwdCall->getArgOperand(1) && offsetScale == fwdCall->getArgOperand(2) &&
+                mask == fwdCall->getArgOperand(5)) {
+                SourcePos fwdPos;
+                LLVMGetSourcePosFromMetadata(fwdCall, &fwdPos);
+                Debug(fwdPos, "This scatter can be coalesced.");
+                coalesceGroup.push_back(fwdCall);
+                // "iter" must not point to a scatter of the group, which is
+                // erased if the group is coalesced.
+                if (fwdCall == &*iter) {
+                    iter++;
+                }
+
+                if (coalesceGroup.size() == 4) {
+                    // Same window as for the gathers.
+                    break;
+                }
+                continue;
+            }
+
+            if (!llvm::isGuaranteedToTransferExecutionToSuccessor(&*fwdIter)) {
+                break;
+            }
+            if (fwdIter->mayReadOrWriteMemory() && llvm::isModOrRefSet(AA.getModRefInfo(&*fwdIter, scatterLoc))) {
+                break;
+            }
+        }
+
+        Debug(pos, "Done with checking for matching scatters");
+
+        modifiedAny |= lCoalesceScatters(coalesceGroup, baseType);
+    }
+    DEBUG_END_BB("ScatterCoalescePass");
+
+    return modifiedAny;
+}
+
+llvm::PreservedAnalyses ScatterCoalescePass::run(llvm::Function &F, llvm::FunctionAnalysisManager &FAM) {
+    llvm::TimeTraceScope FuncScope("ScatterCoalescePass::run", F.getName());
+
+    llvm::AAResults &AA = FAM.getResult<llvm::AAManager>(F);
+    bool modifiedAny = false;
+    for (llvm::BasicBlock &BB : F) {
+        modifiedAny |= coalesceScattersFactored(BB, AA);
+    }
+
+    if (!modifiedAny) {
+        // No changes, all analyses are preserved.
+        return llvm::PreservedAnalyses::all();
+    }
+
+    llvm::PreservedAnalyses PA;
+    PA.preserveSet<llvm::CFGAnalyses>();
+    return PA;
+}
+
+} // namespace ispc
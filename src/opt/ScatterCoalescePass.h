@@ -0,0 +1,43 @@
+/*
+  Copyright (c) 2026, Intel Corporation
+
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#include "ISPCPass.h"
+
+#include <llvm/Analysis/AliasAnalysis.h>
+
+namespace ispc {
+
+// This pass is the counterpart of GatherCoalescePass for scatters.  If we
+// have a series of scatters that share the base pointer, the varying
+// offsets (which have to be the same in all of the lanes) and the mask, and
+// the memory they write isn't accessed by the instructions in between, then
+// we analyze their writes collectively.  Runs of adjacent elements are
+// written with vector stores of values assembled from the scattered values
+// with shuffles.  This is the typical case of AOS data written back, e.g.
+// "p[i].x = ...; p[i].y = ...; p[i].z = ...;".
+//
+// A vector store writes all of the elements it covers, so only elements
+// written by one of the scatters are ever stored to.  When the mask isn't
+// known at compile time, the stores are emitted as masked stores.
+//
+// Only the factored scatters of targets without hardware scatters are
+// handled; AVX-512 targets keep their hardware scatters.
+
+struct ScatterCoalescePass : public llvm::PassInfoMixin<ScatterCoalescePass> {
+
+    llvm::PreservedAnalyses run(llvm::Function &F, llvm::FunctionAnalysisManager &FAM);
+
+  private:
+    // Type of base pointer element type (the 1st argument of the intrinsic) is i8
+    // e.g. @__pseudo_scatter_factored_base_offsets32_i32(i8 *, <WIDTH x i32>, i32, <WIDTH x i32>,
+    //                                                    <WIDTH x i32>, <WIDTH x MASK>)
+    llvm::Type *baseType{LLVMTypes::Int8Type};
+    bool coalesceScattersFactored(llvm::BasicBlock &BB, llvm::AAResults &AA);
+};
+
+} // namespace ispc
@@ -0,0 +1,181 @@
+/*
+  Copyright (c) 2026, Intel Corporation
+
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "SpecializeUniformArgs.h"
+
+#include <algorithm>
+#include <map>
+
+#include <llvm/Analysis/VectorUtils.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+
+namespace ispc {
+
+/** Maximum number of clones created for a single function. */
+constexpr int maxClonesPerFunction = 4;
+
+/** Returns true if the given function may be cloned for uniform
+    arguments. */
+static bool lCanSpecialize(const llvm::Function &F) {
+    if (F.isDeclaration() || F.isInterposable() || F.isVarArg() || F.getName().starts_with("__") ||
+        F.hasFnAttribute(llvm::Attribute::AlwaysInline)) {
+        return false;
+    }
+    for (const llvm::Argument &arg : F.args()) {
+        if (llvm::isa<llvm::FixedVectorType>(arg.getType())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Returns which of the arguments of the given call are splats of vector
+    type.  All-on masks are left out: calls from code where all of the
+    program instances are running would otherwise be cloned for them
+    alone. */
+static std::vector<bool> lGetUniformArgs(llvm::CallInst *call) {
+    std::vector<bool> uniformArgs(call->arg_size(), false);
+    for (unsigned i = 0; i < call->arg_size(); ++i) {
+        llvm::Value *arg = call->getArgOperand(i);
+        if (arg == LLVMMaskAllOn) {
+            continue;
+        }
+        uniformArgs[i] = llvm::isa<llvm::FixedVectorType>(arg->getType()) && llvm::getSplatValue(arg) != nullptr;
+    }
+    return uniformArgs;
+}
+
+/** Creates a clone of F that takes the element of the vectors passed for
+    the parameters set in uniformArgs, and broadcasts them on entry. */
+static llvm::Function *lCreateUniformClone(llvm::Function *F, const std::vector<bool> &uniformArgs) {
+    std::vector<llvm::Type *> paramTypes;
+    for (llvm::Argument &arg : F->args()) {
+        llvm::Type *type = arg.getType();
+        if (uniformArgs[arg.getArgNo()]) {
+            type = llvm::cast<llvm::FixedVectorType>(type)->getElementType();
+        }
+        paramTypes.push_back(type);
+    }
+    llvm::FunctionType *fType = llvm::FunctionType::get(F->getReturnType(), paramTypes, false);
+    llvm::Function *clone = llvm::Function::Create(fType, llvm::GlobalValue::InternalLinkage, F->getAddressSpace(),
+                                                   F->getName() + ".uniform", F->getParent());
+
+    // Broadcast the uniform arguments in a block that becomes the entry
+    // block of the clone, and map the other ones to the new arguments.
+    llvm::BasicBlock *entry = llvm::BasicBlock::Create(*g->ctx, "uniform_args", clone);
+    llvm::IRBuilder<> builder(entry);
+    llvm::ValueToValueMapTy vmap;
+    for (llvm::Argument &arg : F->args()) {
+        llvm::Argument *newArg = clone->getArg(arg.getArgNo());
+        newArg->setName(arg.getName());
+        if (uniformArgs[arg.getArgNo()]) {
+            auto *vecType = llvm::cast<llvm::FixedVectorType>(arg.getType());
+            vmap[&arg] = builder.CreateVectorSplat(vecType->getNumElements(), newArg, arg.getName() + "_broadcast");
+        } else {
+            vmap[&arg] = newArg;
+        }
+    }
+
+    llvm::SmallVector<llvm::ReturnInst *, 8> returns;
+    llvm::CloneFunctionInto(clone, F, vmap, llvm::CloneFunctionChangeType::LocalChangesOnly, returns);
+    clone->setLinkage(llvm::GlobalValue::InternalLinkage);
+    clone->setVisibility(llvm::GlobalValue::DefaultVisibility);
+    clone->setDLLStorageClass(llvm::GlobalValue::DefaultStorageClass);
+    clone->setComdat(nullptr);
+
+    // Merge the cloned entry block into the new one, so that the allocas
+    // stay in the entry block.
+    llvm::BasicBlock *clonedEntry = llvm::cast<llvm::BasicBlock>(vmap[&F->getEntryBlock()]);
+    builder.CreateBr(clonedEntry);
+    llvm::MergeBlockIntoPredecessor(clonedEntry);
+
+    return clone;
+}
+
+/** Replaces the given call with a call to the clone, passing the scalar
+    values of the uniform arguments. */
+static void lRedirectCall(llvm::CallInst *call, llvm::Function *clone, const std::vector<bool> &uniformArgs) {
+    std::vector<llvm::Value *> args;
+    for (unsigned i = 0; i < call->arg_size(); ++i) {
+        llvm::Value *arg = call->getArgOperand(i);
+        args.push_back(uniformArgs[i] ? llvm::getSplatValue(arg) : arg);
+    }
+
+    llvm::CallInst *newCall = llvm::CallInst::Create(clone, args, "", ISPC_INSERTION_POINT_INSTRUCTION(call));
+    newCall->setCallingConv(call->getCallingConv());
+    newCall->setTailCallKind(call->getTailCallKind());
+    newCall->setDebugLoc(call->getDebugLoc());
+    newCall->copyMetadata(*call);
+
+    // Keep the attributes of the call, except those of the uniform arguments.
+    llvm::AttributeList attrs = call->getAttributes();
+    for (unsigned i = 0; i < call->arg_size(); ++i) {
+        if (uniformArgs[i]) {
+            attrs = attrs.removeParamAttributes(*g->ctx, i);
+        }
+    }
+    newCall->setAttributes(attrs);
+
+    newCall->takeName(call);
+    call->replaceAllUsesWith(newCall);
+    call->eraseFromParent();
+}
+
+llvm::PreservedAnalyses SpecializeUniformArgsPass::run(llvm::Module &M, llvm::ModuleAnalysisManager &MAM) {
+    llvm::TimeTraceScope FuncScope("SpecializeUniformArgsPass::run");
+    if (g->target->isXeTarget()) {
+        return llvm::PreservedAnalyses::all();
+    }
+
+    std::vector<llvm::Function *> functions;
+    for (llvm::Function &F : M) {
+        if (lCanSpecialize(F)) {
+            functions.push_back(&F);
+        }
+    }
+
+    bool modifiedAny = false;
+    for (llvm::Function *F : functions) {
+        // Group the direct calls of the function by the set of splat
+        // arguments they pass.
+        std::map<std::vector<bool>, std::vector<llvm::CallInst *>> callsByUniformArgs;
+        for (llvm::User *user : F->users()) {
+            llvm::CallInst *call = llvm::dyn_cast<llvm::CallInst>(user);
+            if (call == nullptr || call->getCalledOperand() != F || call->isMustTailCall() ||
+                call->getFunctionType() != F->getFunctionType()) {
+                continue;
+            }
+            std::vector<bool> uniformArgs = lGetUniformArgs(call);
+            if (std::find(uniformArgs.begin(), uniformArgs.end(), true) != uniformArgs.end()) {
+                callsByUniformArgs[uniformArgs].push_back(call);
+            }
+        }
+
+        int nClones = 0;
+        for (auto &[uniformArgs, calls] : callsByUniformArgs) {
+            if (nClones++ == maxClonesPerFunction) {
+                break;
+            }
+            llvm::Function *clone = lCreateUniformClone(F, uniformArgs);
+            Debug(SourcePos(), "Specialized \"%s\" as \"%s\" for %d calls with uniform arguments.",
+                  F->getName().str().c_str(), clone->getName().str().c_str(), (int)calls.size());
+            for (llvm::CallInst *call : calls) {
+                lRedirectCall(call, clone, uniformArgs);
+            }
+            modifiedAny = true;
+        }
+    }
+
+    if (!modifiedAny) {
+        return llvm::PreservedAnalyses::all();
+    }
+    llvm::PreservedAnalyses PA;
+    PA.preserveSet<llvm::CFGAnalyses>();
+    return PA;
+}
+
+} // namespace ispc
@@ -0,0 +1,37 @@
+/*
+  Copyright (c) 2026, Intel Corporation
+
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#include "ISPCPass.h"
+
+namespace ispc {
+
+/** Functions often take varying parameters that some of their callers
+    always pass values broadcast from uniform ones, which forces gathers
+    and varying control flow in the callee.  This pass looks for direct
+    calls that pass splats for vector parameters and redirects them to
+    clones of the callee that take the scalar values instead, and
+    broadcast them on entry.  The following optimizations then see that
+    these values are the same in all of the program instances.
+
+    The pass runs after the inliner, so only the functions that weren't
+    inlined (noinline ones and ones too large to inline) are cloned.  One
+    clone is created for each different set of splat parameters, up to a
+    small limit per function; all-on masks don't count, so calls that only
+    pass the all-on mask aren't specialized.  ISPC builtins
+    (functions whose names start with "__") and functions whose definition
+    may be replaced at link time are left alone.
+ */
+class SpecializeUniformArgsPass : public llvm::PassInfoMixin<SpecializeUniformArgsPass> {
+  public:
+    explicit SpecializeUniformArgsPass() {}
+
+    static llvm::StringRef getPassName() { return "Specialize functions for uniform arguments"; }
+    llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &MAM);
+};
+
+} // namespace ispc
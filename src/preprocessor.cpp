@@ -9,6 +9,7 @@
 */
 
 #include "binary_type.h"
+#include "compile_report.h"
 #include "ispc.h"
 #include "ispc_version.h"
 #include "module.h"
@@ -19,6 +20,7 @@
 #include <ctype.h>
 #include <fcntl.h>
 #include <memory>
+#include <set>
 #include <stdio.h>
 #include <string>
 #include <utility>
@@ -44,7 +46,9 @@
 #include <clang/Frontend/Utils.h>
 #include <clang/Lex/HeaderSearch.h>
 #include <clang/Lex/HeaderSearchOptions.h>
+#include <clang/Lex/Lexer.h>
 #include <clang/Lex/ModuleLoader.h>
+#include <clang/Lex/PPCallbacks.h>
 #include <clang/Lex/Preprocessor.h>
 #include <clang/Lex/PreprocessorOptions.h>
 #include <llvm/ADT/IntrusiveRefCntPtr.h>
@@ -54,6 +58,8 @@
 #include <llvm/IR/Module.h>
 #include <llvm/Support/Error.h>
 #include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/VirtualFileSystem.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/TargetParser/Host.h>
 #include <llvm/TargetParser/Triple.h>
@@ -369,10 +375,84 @@ static void lSetPreprocessorOptions(const std::shared_ptr<clang::PreprocessorOpt
 
 static void lSetLangOptions(clang::LangOptions *opts) { opts->LineComment = 1; }
 
+/** Create the file system to read the source files from: the real one,
+    overlaid with the in-memory files if there are any. */
+static llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> lCreateFileSystem(const Module::VirtualFiles *virtualFiles) {
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> realFS = llvm::vfs::getRealFileSystem();
+    if (virtualFiles == nullptr || virtualFiles->empty()) {
+        return realFS;
+    }
+
+    llvm::IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem> memoryFS(new llvm::vfs::InMemoryFileSystem);
+    memoryFS->setCurrentWorkingDirectory(g->currentDirectory);
+    for (const auto &[name, content] : *virtualFiles) {
+        memoryFS->addFile(name, 0, llvm::MemoryBuffer::getMemBufferCopy(content, name));
+    }
+
+    llvm::IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> overlayFS(new llvm::vfs::OverlayFileSystem(realFS));
+    overlayFS->pushOverlay(memoryFS);
+    return overlayFS;
+}
+
+/** Collects the names of the files entered by the preprocessor, spelled as
+    in the line markers of the preprocessor output, from which the parser
+    registers the dependencies of a module. */
+class IncludeCollector : public clang::PPCallbacks {
+  public:
+    IncludeCollector(clang::SourceManager &srcMgr, std::set<std::string> &dependencies)
+        : m_srcMgr(srcMgr), m_dependencies(dependencies) {}
+
+    void FileChanged(clang::SourceLocation loc, FileChangeReason reason, clang::SrcMgr::CharacteristicKind,
+                     clang::FileID) override {
+        if (reason != EnterFile) {
+            return;
+        }
+        clang::PresumedLoc presumed = m_srcMgr.getPresumedLoc(loc);
+        if (presumed.isValid()) {
+            m_dependencies.insert(clang::Lexer::Stringify(presumed.getFilename()));
+        }
+    }
+
+  private:
+    clang::SourceManager &m_srcMgr;
+    std::set<std::string> &m_dependencies;
+};
+
+/** Records the name of the stdlib.isph header included from the predefines
+    buffer, in the form used by the line markers of the output. */
+class StdlibHeaderLocator : public clang::PPCallbacks {
+  public:
+    StdlibHeaderLocator(clang::SourceManager &srcMgr, std::string &name) : m_srcMgr(srcMgr), m_name(name) {}
+
+    void FileChanged(clang::SourceLocation loc, FileChangeReason reason, clang::SrcMgr::CharacteristicKind,
+                     clang::FileID) override {
+        if (reason != EnterFile || !m_name.empty()) {
+            return;
+        }
+        clang::PresumedLoc presumed = m_srcMgr.getPresumedLoc(loc);
+        if (!presumed.isValid() || llvm::sys::path::filename(presumed.getFilename()) != "stdlib.isph") {
+            return;
+        }
+        clang::PresumedLoc includer = m_srcMgr.getPresumedLoc(presumed.getIncludeLoc());
+        if (includer.isValid() && llvm::StringRef(includer.getFilename()) == "<built-in>") {
+            m_name = clang::Lexer::Stringify(presumed.getFilename());
+        }
+    }
+
+  private:
+    clang::SourceManager &m_srcMgr;
+    std::string &m_name;
+};
+
 /** Run the preprocessor on the given file, writing to the output stream.
+    If dependencies is not nullptr, the file is only scanned for the files
+    it includes and no output is produced. If stdlibHeader is not nullptr,
+    the name of the implicitly included stdlib.isph is stored there.
     Returns the number of diagnostic errors encountered. */
-static int lExecPreprocessor(llvm::Module *module, const char *infilename, llvm::raw_string_ostream *ostream,
-                             Globals::PreprocessorOutputType preprocessorOutputType) {
+static int lExecPreprocessor(const llvm::Triple &moduleTriple, const char *infilename,
+                             const Module::VirtualFiles *virtualFiles, llvm::raw_string_ostream *ostream,
+                             Globals::PreprocessorOutputType preprocessorOutputType,
+                             std::set<std::string> *dependencies = nullptr, std::string *stdlibHeader = nullptr) {
     clang::FrontendInputFile inputFile(infilename, clang::InputKind());
 
     // Create completely isolated diagnostic infrastructure
@@ -395,7 +475,7 @@ static int lExecPreprocessor(llvm::Module *module, const char *infilename, llvm:
 
     // Create TargetInfo
     const std::shared_ptr<clang::TargetOptions> tgtOpts = std::make_shared<clang::TargetOptions>();
-    llvm::Triple triple(module->getTargetTriple());
+    llvm::Triple triple(moduleTriple);
     if (triple.getTriple().empty()) {
         triple.setTriple(llvm::sys::getDefaultTargetTriple());
     }
@@ -424,7 +504,7 @@ static int lExecPreprocessor(llvm::Module *module, const char *infilename, llvm:
 
     // Create and initialize SourceManager
     clang::FileSystemOptions fsOpts;
-    clang::FileManager fileMgr(fsOpts);
+    clang::FileManager fileMgr(fsOpts, lCreateFileSystem(virtualFiles));
     clang::SourceManager srcMgr(diagEng, fileMgr);
     lInitializeSourceManager(inputFile, diagEng, fileMgr, srcMgr);
 
@@ -451,7 +531,19 @@ static int lExecPreprocessor(llvm::Module *module, const char *infilename, llvm:
 
     // do actual preprocessing
     diagPrinter.BeginSourceFile(langOpts, &prep);
-    clang::DoPrintPreprocessedInput(prep, ostream, preProcOutOpts);
+    if (stdlibHeader != nullptr) {
+        prep.addPPCallbacks(std::make_unique<StdlibHeaderLocator>(srcMgr, *stdlibHeader));
+    }
+    if (dependencies != nullptr) {
+        prep.addPPCallbacks(std::make_unique<IncludeCollector>(srcMgr, *dependencies));
+        prep.EnterMainSourceFile();
+        clang::Token token;
+        do {
+            prep.Lex(token);
+        } while (token.isNot(clang::tok::eof));
+    } else {
+        clang::DoPrintPreprocessedInput(prep, ostream, preProcOutOpts);
+    }
     diagPrinter.EndSourceFile();
 
     // Output any collected diagnostic messages to stderr
@@ -528,20 +620,41 @@ static void lClearCPPBuffer(std::unique_ptr<CPPBuffer> &bufferCPP) {
     }
 }
 
+int Module::Preprocess(std::string &result) {
+    llvm::raw_string_ostream os(result);
+    int numErrors = lExecPreprocessor(llvm::Triple(module->getTargetTriple()), srcFile, virtualFiles, &os,
+                                      Globals::PreprocessorOutputType::Cpp);
+    os.flush();
+    return numErrors;
+}
+
 int Module::preprocessAndParse() {
     llvm::SmallVector<llvm::StringRef, 6> refs;
 
     lInitCPPBuffer(bufferCPP);
 
-    const int numErrors = lExecPreprocessor(module, srcFile, bufferCPP->os.get(), g->preprocessorOutputType);
+    int numErrors = 0;
+    {
+        CompileReportScope ReportScope("preprocess");
+        numErrors = lExecPreprocessor(llvm::Triple(module->getTargetTriple()), srcFile, virtualFiles,
+                                      bufferCPP->os.get(), g->preprocessorOutputType, nullptr, &stdlibHeaderName);
+    }
     errorCount += (g->ignoreCPPErrors) ? 0 : numErrors;
 
     if (g->onlyCPP) {
         return errorCount; // Return early
     }
 
-    lParseCPPBuffer(bufferCPP);
+    {
+        CompileReportScope ReportScope("parse");
+        lParseCPPBuffer(bufferCPP);
+    }
     lClearCPPBuffer(bufferCPP);
 
     return 0;
 }
+
+int Module::scanDependencies(const char *srcFile, std::set<std::string> &dependencies) {
+    return lExecPreprocessor(g->target->GetTriple(), srcFile, nullptr, nullptr, Globals::PreprocessorOutputType::Cpp,
+                             &dependencies);
+}
@@ -35,6 +35,14 @@ Symbol::~Symbol() {
     }
 }
 
+llvm::Function *Symbol::GetFunction() {
+    if (function == nullptr && deferredFunction) {
+        function = deferredFunction();
+        deferredFunction = nullptr;
+    }
+    return function;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // TemplateSymbol
 
@@ -16,6 +16,7 @@
 #include "decl.h"
 #include "ispc.h"
 
+#include <functional>
 #include <map>
 
 namespace ispc {
@@ -64,7 +65,12 @@ class Symbol : public Traceable {
                                    its location in memory and its element type.) */
     llvm::Function *function; /*!< For symbols that represent functions,
                                    this stores the LLVM Function value for
-                                   the symbol once it has been created. */
+                                   the symbol once it has been created. Use
+                                   GetFunction() to read it. */
+    std::function<llvm::Function *()> deferredFunction;
+    /*!< For function symbols whose LLVM declaration is
+         created on first use, this creates it (see
+         Module::AddFunctionDeclaration()). */
     llvm::Function *exportedFunction;
     /*!< For symbols that represent functions with
          'export' qualifiers, this points to the LLVM
@@ -101,6 +107,10 @@ class Symbol : public Traceable {
     /* */
     SymbolKind GetSymbolKind() const { return kind; }
 
+    /** Returns the LLVM Function for a function symbol, creating its
+        declaration in the current module if it has been deferred. */
+    llvm::Function *GetFunction();
+
   private:
     SymbolKind kind;
 };
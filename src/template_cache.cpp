@@ -0,0 +1,374 @@
+/*
+  Copyright (c) 2026, Intel Corporation
+
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+/** @file template_cache.cpp
+    @brief Implementation of the cache of optimized template instantiations.
+*/
+
+#include "template_cache.h"
+#include "ispc.h"
+#include "ispc_version.h"
+#include "opt.h"
+#include "util.h"
+
+#include <memory>
+#include <unordered_set>
+#include <utility>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalAlias.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA256.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+
+using namespace ispc;
+
+// Must be changed when the way entries are produced changes.
+static const char *lTemplateCacheFormatVersion = "1";
+
+// Returns the global values transitively referenced by the roots, including
+// the roots themselves, in a deterministic order.
+static std::vector<llvm::GlobalValue *> lCollectUses(const std::vector<llvm::GlobalValue *> &roots) {
+    std::vector<llvm::GlobalValue *> uses;
+    std::unordered_set<const llvm::Value *> visited;
+    std::vector<llvm::Value *> worklist(roots.rbegin(), roots.rend());
+    auto isTraversed = [](const llvm::Value *V) {
+        return llvm::isa<llvm::GlobalValue>(V) || llvm::isa<llvm::ConstantExpr>(V) ||
+               llvm::isa<llvm::ConstantAggregate>(V);
+    };
+
+    while (!worklist.empty()) {
+        llvm::Value *V = worklist.back();
+        worklist.pop_back();
+        if (!visited.insert(V).second) {
+            continue;
+        }
+
+        std::vector<llvm::Value *> operands;
+        if (auto *F = llvm::dyn_cast<llvm::Function>(V)) {
+            if (F->hasPersonalityFn()) {
+                operands.push_back(F->getPersonalityFn());
+            }
+            for (llvm::BasicBlock &BB : *F) {
+                for (llvm::Instruction &I : BB) {
+                    for (llvm::Value *op : I.operands()) {
+                        if (isTraversed(op)) {
+                            operands.push_back(op);
+                        }
+                    }
+                }
+            }
+        } else if (auto *GV = llvm::dyn_cast<llvm::GlobalVariable>(V)) {
+            if (GV->hasInitializer()) {
+                operands.push_back(GV->getInitializer());
+            }
+        } else if (auto *GA = llvm::dyn_cast<llvm::GlobalAlias>(V)) {
+            operands.push_back(GA->getAliasee());
+        } else if (auto *C = llvm::dyn_cast<llvm::Constant>(V)) {
+            for (llvm::Value *op : C->operands()) {
+                if (isTraversed(op)) {
+                    operands.push_back(op);
+                }
+            }
+        }
+        if (auto *GV = llvm::dyn_cast<llvm::GlobalValue>(V)) {
+            uses.push_back(GV);
+        }
+        worklist.insert(worklist.end(), operands.rbegin(), operands.rend());
+    }
+    return uses;
+}
+
+// Returns true if the cached code may refer to the global value by name
+// instead of carrying its own copy: the definition must be visible to, and
+// the same in, every translation unit.
+static bool lIsShared(const llvm::GlobalValue *GV) {
+    return GV != nullptr && !GV->hasLocalLinkage() && !GV->isDiscardableIfUnused();
+}
+
+// Code referencing aliases or mutable data private to the translation unit
+// can't be shared between translation units.
+static bool lIsCacheable(const std::vector<llvm::GlobalValue *> &uses) {
+    for (const llvm::GlobalValue *GV : uses) {
+        if (llvm::isa<llvm::GlobalAlias>(GV) || llvm::isa<llvm::GlobalIFunc>(GV)) {
+            return false;
+        }
+        auto *var = llvm::dyn_cast<llvm::GlobalVariable>(GV);
+        if (var && !var->isConstant() && !lIsShared(var)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Copies the definitions of the given global values to a new module; all the
+// other global values referenced by them become declarations.
+static std::unique_ptr<llvm::Module> lCloneDefinitions(const llvm::Module *module,
+                                                       const std::unordered_set<const llvm::GlobalValue *> &defs,
+                                                       llvm::ValueToValueMapTy &VMap) {
+    std::unique_ptr<llvm::Module> copy =
+        llvm::CloneModule(*module, VMap, [&defs](const llvm::GlobalValue *GV) { return defs.count(GV) != 0; });
+    copy->setModuleIdentifier("");
+    copy->setSourceFileName("");
+
+    // Drop the declarations of everything the copied code doesn't refer to.
+    std::vector<llvm::GlobalValue *> unused;
+    for (llvm::GlobalValue &GV : copy->global_values()) {
+        if (GV.isDeclaration() && GV.use_empty()) {
+            unused.push_back(&GV);
+        }
+    }
+    for (llvm::GlobalValue *GV : unused) {
+        GV->eraseFromParent();
+    }
+    return copy;
+}
+
+// The key covers the unoptimized IR of the function and of everything it
+// references, so it doesn't depend on the rest of the translation unit.
+static std::string lComputeKey(const llvm::Module *module, llvm::Function *func,
+                               const std::vector<llvm::GlobalValue *> &uses, int optLevel) {
+    llvm::SHA256 hasher;
+    auto hashString = [&hasher](llvm::StringRef str) {
+        hasher.update(str);
+        hasher.update(llvm::StringRef("\0", 1));
+    };
+
+    hashString(lTemplateCacheFormatVersion);
+    hashString(ISPC_VERSION_STRING);
+    hashString(std::to_string(optLevel));
+    // The options that change the optimization pipeline.
+    for (const std::string &arg : g->cacheKeyArgs) {
+        llvm::StringRef ref(arg);
+        if (ref.starts_with("--opt=") || ref.starts_with("-O") || ref.starts_with("--off-phase")) {
+            hashString(arg);
+        }
+    }
+    hashString(func->getName());
+
+    // Print a standalone copy of the closure, so that the numbering of
+    // attribute groups and metadata doesn't depend on the rest of the module.
+    llvm::ValueToValueMapTy VMap;
+    std::unordered_set<const llvm::GlobalValue *> defs(uses.begin(), uses.end());
+    std::unique_ptr<llvm::Module> copy = lCloneDefinitions(module, defs, VMap);
+    std::string text;
+    llvm::raw_string_ostream os(text);
+    copy->print(os, nullptr);
+    os.flush();
+    hashString(text);
+
+    return llvm::toHex(hasher.final(), /* LowerCase */ true);
+}
+
+std::string TemplateCache::entryPath(const std::string &key) const {
+    llvm::SmallString<256> path(m_dir);
+    llvm::sys::path::append(path, key.substr(0, 2), key + ".bc");
+    return std::string(path.str());
+}
+
+void TemplateCache::store(llvm::Module *module, llvm::Function *func, const std::string &key, int optLevel) {
+    // The copy also gets the persistent builtins, since the optimization
+    // lowers calls of pseudo functions to them.
+    std::unordered_set<const llvm::GlobalValue *> defs;
+    std::vector<llvm::GlobalValue *> roots = {func};
+    for (const char *name : {"llvm.used", "llvm.compiler.used"}) {
+        if (llvm::GlobalVariable *used = module->getNamedGlobal(name)) {
+            roots.push_back(used);
+        }
+    }
+    for (llvm::GlobalValue *GV : lCollectUses(roots)) {
+        defs.insert(GV);
+    }
+
+    llvm::ValueToValueMapTy VMap;
+    std::unique_ptr<llvm::Module> copy = lCloneDefinitions(module, defs, VMap);
+    llvm::Function *copyFunc = llvm::cast<llvm::Function>(VMap[func]);
+    // Keep the function and its signature through the optimization.
+    copyFunc->setLinkage(llvm::GlobalValue::ExternalLinkage);
+    Optimize(copy.get(), optLevel);
+
+    // Leave in the entry only what can't be found by name in the module the
+    // function is linked into later.
+    std::vector<llvm::GlobalVariable *> appending;
+    for (llvm::GlobalVariable &GV : copy->globals()) {
+        if (GV.hasAppendingLinkage()) {
+            appending.push_back(&GV);
+            continue;
+        }
+        GV.setComdat(nullptr);
+        if (GV.isDeclaration()) {
+            continue;
+        }
+        if (lIsShared(module->getNamedValue(GV.getName()))) {
+            GV.setInitializer(nullptr);
+            GV.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        } else if (GV.isConstant()) {
+            GV.setLinkage(llvm::GlobalValue::InternalLinkage);
+        } else {
+            return;
+        }
+    }
+    for (llvm::GlobalVariable *GV : appending) {
+        GV->eraseFromParent();
+    }
+    for (llvm::Function &F : *copy) {
+        F.setComdat(nullptr);
+        if (&F == copyFunc || F.isDeclaration()) {
+            continue;
+        }
+        if (lIsShared(module->getNamedValue(F.getName()))) {
+            F.deleteBody();
+        } else {
+            F.setLinkage(llvm::GlobalValue::InternalLinkage);
+        }
+    }
+    // Remove what the optimized function doesn't need anymore.
+    for (bool changed = true; changed;) {
+        changed = false;
+        std::vector<llvm::GlobalValue *> unused;
+        for (llvm::GlobalValue &GV : copy->global_values()) {
+            GV.removeDeadConstantUsers();
+            if (&GV != copyFunc && GV.use_empty() && (GV.hasLocalLinkage() || GV.isDeclaration())) {
+                unused.push_back(&GV);
+            }
+        }
+        for (llvm::GlobalValue *GV : unused) {
+            GV->eraseFromParent();
+            changed = true;
+        }
+    }
+    if (llvm::verifyModule(*copy)) {
+        return;
+    }
+
+    // Entries are written under a unique name and renamed, so concurrent
+    // compilations never see partially written ones.
+    std::string entry = entryPath(key);
+    if (llvm::sys::fs::create_directories(llvm::sys::path::parent_path(entry))) {
+        return;
+    }
+    int fd = -1;
+    llvm::SmallString<256> tmpPath;
+    if (llvm::sys::fs::createUniqueFile(entry + "-%%%%%%.tmp", fd, tmpPath)) {
+        return;
+    }
+    bool written = false;
+    {
+        llvm::raw_fd_ostream os(fd, /* shouldClose */ true);
+        llvm::WriteBitcodeToFile(*copy, os);
+        os.close();
+        written = !os.has_error();
+    }
+    if (!written || llvm::sys::fs::rename(tmpPath, entry)) {
+        llvm::sys::fs::remove(tmpPath);
+    }
+}
+
+bool TemplateCache::load(llvm::Module *module, llvm::Function *func, const std::string &key) {
+    auto buffer = llvm::MemoryBuffer::getFile(entryPath(key));
+    if (!buffer) {
+        return false;
+    }
+    llvm::Expected<std::unique_ptr<llvm::Module>> cached =
+        llvm::parseBitcodeFile((*buffer)->getMemBufferRef(), *g->ctx);
+    if (!cached) {
+        llvm::consumeError(cached.takeError());
+        return false;
+    }
+    llvm::Function *cachedFunc = (*cached)->getFunction(func->getName());
+    if (cachedFunc == nullptr || cachedFunc->isDeclaration()) {
+        return false;
+    }
+    std::string cachedName = func->getName().str() + ".cached";
+    cachedFunc->setName(cachedName);
+    if (llvm::Linker::linkModules(*module, std::move(*cached))) {
+        return false;
+    }
+
+    // Types are mapped to the ones of the module by the linker.
+    cachedFunc = module->getFunction(cachedName);
+    if (cachedFunc == nullptr) {
+        return false;
+    }
+    if (cachedFunc->getFunctionType() != func->getFunctionType()) {
+        cachedFunc->eraseFromParent();
+        return false;
+    }
+
+    // Move the body over keeping the linkage and attributes of the function.
+    func->dropAllReferences();
+    for (auto args : llvm::zip(cachedFunc->args(), func->args())) {
+        std::get<0>(args).replaceAllUsesWith(&std::get<1>(args));
+    }
+    func->splice(func->end(), cachedFunc);
+    cachedFunc->eraseFromParent();
+    return true;
+}
+
+void TemplateCache::Apply(llvm::Module *module, const std::vector<std::string> &instantiations, int optLevel) {
+    std::vector<std::pair<llvm::Function *, std::string>> hits, misses;
+    for (const std::string &name : instantiations) {
+        llvm::Function *func = module->getFunction(name);
+        // Functions that are always inlined are optimized in their callers.
+        if (func == nullptr || func->isDeclaration() || func->hasFnAttribute(llvm::Attribute::AlwaysInline)) {
+            continue;
+        }
+        std::vector<llvm::GlobalValue *> uses = lCollectUses({func});
+        if (!lIsCacheable(uses)) {
+            continue;
+        }
+        std::string key = lComputeKey(module, func, uses, optLevel);
+        if (llvm::sys::fs::exists(entryPath(key))) {
+            hits.push_back({func, key});
+        } else {
+            misses.push_back({func, key});
+        }
+    }
+
+    // Store the missing entries first: they must be produced from the
+    // unoptimized code the keys were computed from.
+    for (const auto &miss : misses) {
+        Debug(SourcePos(), "Template cache miss for \"%s\".", miss.first->getName().str().c_str());
+        store(module, miss.first, miss.second, optLevel);
+    }
+    // An entry that can't be used is ignored and the instantiation is
+    // compiled as usual.
+    for (const auto &hit : hits) {
+        llvm::Function *func = hit.first;
+        if (!load(module, func, hit.second)) {
+            Debug(SourcePos(), "Template cache entry for \"%s\" can't be used.", func->getName().str().c_str());
+            continue;
+        }
+        Debug(SourcePos(), "Template cache hit for \"%s\".", func->getName().str().c_str());
+        // Bodies of functions that may be inlined are optimized again in
+        // their callers anyway.
+        if (func->hasFnAttribute(llvm::Attribute::NoInline) && !func->hasFnAttribute(llvm::Attribute::OptimizeNone)) {
+            func->addFnAttr(llvm::Attribute::OptimizeNone);
+            m_optimized.push_back(func->getName().str());
+        }
+    }
+}
+
+void TemplateCache::Restore(llvm::Module *module) const {
+    for (const std::string &name : m_optimized) {
+        if (llvm::Function *func = module->getFunction(name)) {
+            func->removeFnAttr(llvm::Attribute::OptimizeNone);
+        }
+    }
+}
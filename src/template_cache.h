@@ -0,0 +1,68 @@
+/*
+  Copyright (c) 2026, Intel Corporation
+
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+/** @file template_cache.h
+    @brief On-disk cache of optimized template instantiations shared between
+           translation units (see --template-cache-dir).
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace llvm {
+class Function;
+class Module;
+} // namespace llvm
+
+namespace ispc {
+
+/** @class TemplateCache
+    Every translation unit that instantiates a template with the same
+    arguments generates and optimizes the same function again. The cache
+    stores the optimized body of every instantiation in a directory shared
+    by all compilations, keyed by a hash of the unoptimized IR of the
+    instantiation and of everything it references, so an instantiation that
+    has already been optimized by another compilation is replaced with the
+    cached body before the module is optimized.
+
+    Instantiations that reference mutable data private to the translation
+    unit can't be shared and are always compiled as usual.
+ */
+class TemplateCache {
+  public:
+    explicit TemplateCache(const std::string &dir) : m_dir(dir) {}
+
+    /** Replaces the bodies of the given instantiations of the module with
+        the cached ones and stores the instantiations missing in the cache.
+        Must be called before the module is optimized with the given
+        optimization level. The cached bodies of noinline instantiations are
+        already optimized, so they are marked optnone to be skipped by the
+        optimization of the module; Restore() must be called after it. */
+    void Apply(llvm::Module *module, const std::vector<std::string> &instantiations, int optLevel);
+
+    /** Removes the optnone attributes added by Apply(). */
+    void Restore(llvm::Module *module) const;
+
+  private:
+    /** Returns the path of the cache entry for the key. */
+    std::string entryPath(const std::string &key) const;
+
+    /** Optimizes a copy of the function and the values it references
+        in isolation and stores it in the cache. */
+    void store(llvm::Module *module, llvm::Function *func, const std::string &key, int optLevel);
+
+    /** Replaces the body of the function with the cached one. Returns false
+        if the entry can't be read or doesn't match the function. */
+    bool load(llvm::Module *module, llvm::Function *func, const std::string &key);
+
+    std::string m_dir;
+    /** Instantiations marked optnone by Apply(). */
+    std::vector<std::string> m_optimized;
+};
+
+} // namespace ispc
@@ -41,6 +41,7 @@
 
 #include <llvm/IR/DataLayout.h>
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/Path.h>
 
 #if ISPC_LLVM_VERSION < ISPC_LLVM_21_0
@@ -637,3 +638,26 @@ bool ispc::IsStdin(const char *filepath) {
         return false;
     }
 }
+
+bool ispc::FilesAreEqual(const std::string &fileName1, const std::string &fileName2) {
+    auto buffer1 = llvm::MemoryBuffer::getFile(fileName1, /*IsText*/ false, /*RequiresNullTerminator*/ false);
+    auto buffer2 = llvm::MemoryBuffer::getFile(fileName2, /*IsText*/ false, /*RequiresNullTerminator*/ false);
+    return buffer1 && buffer2 && (*buffer1)->getBuffer() == (*buffer2)->getBuffer();
+}
+
+bool ispc::ReplaceFileIfDifferent(const std::string &tmpFileName, const std::string &fileName) {
+    if (tmpFileName == fileName) {
+        return true;
+    }
+    if (FilesAreEqual(tmpFileName, fileName)) {
+        llvm::sys::fs::remove(tmpFileName);
+        return true;
+    }
+    if (!llvm::sys::fs::rename(tmpFileName, fileName)) {
+        return true;
+    }
+    // Renaming fails e.g. across file systems, fall back to copying.
+    std::error_code EC = llvm::sys::fs::copy_file(tmpFileName, fileName);
+    llvm::sys::fs::remove(tmpFileName);
+    return !EC;
+}
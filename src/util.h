@@ -189,6 +189,18 @@ int TerminalWidth();
 /** Returns true is the filepath represents stdin, otherwise false.
  */
 bool IsStdin(const char *);
+
+/** Returns true if both files exist and have the same content.
+ */
+bool FilesAreEqual(const std::string &fileName1, const std::string &fileName2);
+
+/** Moves tmpFileName to fileName unless fileName already has the same
+    content. In the latter case tmpFileName is removed and fileName keeps its
+    modification time, so build systems don't rebuild what depends on it.
+    Does nothing if both names are the same. Returns false if the file can't
+    be replaced.
+ */
+bool ReplaceFileIfDifferent(const std::string &tmpFileName, const std::string &fileName);
 } // namespace ispc
 
 /** Global variable for yacc/bison parser debugging.
@@ -0,0 +1,58 @@
+// This test verifies that ISPC C++ library selects the JIT target from the
+// host CPU when no target is given and reports the selected target.
+
+// RUN: %{cxx} -x c++ -std=c++17 -I%{ispc_include} %s -L%{ispc_lib} -lispc -o %t.bin
+// RUN: env LD_LIBRARY_PATH=%{ispc_lib} %t.bin | FileCheck %s
+
+// REQUIRES: LINUX_HOST && X86_64_HOST
+
+// CHECK: Host target test: SUCCESS
+// CHECK: Explicit target: sse4.2-i32x4
+// CHECK: Explicit target width: 4
+// CHECK-NOT: FAILED
+
+// REQUIRES: ISPC_LIBRARY_JIT && !ASAN_RUN
+
+#include <iostream>
+#include <string>
+#include "ispc/ispc.h"
+
+typedef int (*width_func_t)();
+
+static const char *source = "export uniform int width() { return programCount; }\n";
+
+static int compileAndGetWidth(ispc::ISPCEngine &engine) {
+    if (engine.CompileFromSourceToJit(source, "width.ispc") != 0) {
+        return -1;
+    }
+    auto func = reinterpret_cast<width_func_t>(engine.GetJitFunction("width"));
+    return func ? func() : -1;
+}
+
+int main() {
+    if (!ispc::Initialize()) {
+        std::cerr << "Failed to initialize ISPC\n";
+        return 1;
+    }
+
+    // Test 1: the target is detected and the code is compiled for it.
+    {
+        auto engine = ispc::ISPCEngine::CreateFromArgs({});
+        std::string target = engine ? engine->GetJitTarget() : "";
+        int width = engine ? compileAndGetWidth(*engine) : -1;
+        // Target names end with the number of program instances, e.g. "avx2-i32x8".
+        size_t x = target.rfind('x');
+        bool passed = x != std::string::npos && std::to_string(width) == target.substr(x + 1);
+        std::cout << "Host target test: " << (passed ? "SUCCESS" : "FAILED") << " (" << target << ")\n";
+    }
+
+    // Test 2: an explicit target is used as is.
+    {
+        auto engine = ispc::ISPCEngine::CreateFromArgs({"--target=sse4-i32x4"});
+        std::cout << "Explicit target: " << (engine ? engine->GetJitTarget() : "FAILED") << "\n";
+        std::cout << "Explicit target width: " << (engine ? compileAndGetWidth(*engine) : -1) << "\n";
+    }
+
+    ispc::Shutdown();
+    return 0;
+}
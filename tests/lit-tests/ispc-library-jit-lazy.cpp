@@ -0,0 +1,56 @@
+// This test verifies that ISPC C++ library compiles JIT functions lazily: a
+// function that references an undefined symbol doesn't prevent the other
+// functions of the module from being used as long as it is never called.
+
+// RUN: %{cxx} -x c++ -std=c++17 -I%{ispc_include} %s -L%{ispc_lib} -lispc -o %t.bin
+// RUN: env LD_LIBRARY_PATH=%{ispc_lib} %t.bin | FileCheck %s
+
+// REQUIRES: LINUX_HOST
+
+// CHECK: add_one: 42
+// CHECK: sum: 10
+// CHECK: Late configuration test: SUCCESS
+
+// REQUIRES: ISPC_LIBRARY_JIT && !ASAN_RUN
+
+#include <iostream>
+#include "ispc/ispc.h"
+
+typedef int (*add_one_func_t)(int x);
+typedef float (*sum_func_t)(float vin[], int count);
+
+static const char *source = "extern \"C\" uniform int undefined_function(uniform int x);\n"
+                            "export uniform int never_called(uniform int x) { return undefined_function(x); }\n"
+                            "export uniform int add_one(uniform int x) { return x + 1; }\n"
+                            "export uniform float sum(uniform float vin[], uniform int count) {\n"
+                            "    float s = 0;\n"
+                            "    foreach (i = 0 ... count) { s += vin[i]; }\n"
+                            "    return reduce_add(s);\n"
+                            "}\n";
+
+int main() {
+    if (!ispc::Initialize()) {
+        std::cerr << "Failed to initialize ISPC\n";
+        return 1;
+    }
+
+    auto engine = ispc::ISPCEngine::CreateFromArgs({});
+    if (!engine || !engine->SetJitLazyCompilation(true) || engine->CompileFromSourceToJit(source, "lazy.ispc") != 0) {
+        std::cout << "Compilation: FAILED\n";
+        return 1;
+    }
+
+    auto addOne = reinterpret_cast<add_one_func_t>(engine->GetJitFunction("add_one"));
+    auto sum = reinterpret_cast<sum_func_t>(engine->GetJitFunction("sum"));
+    float data[] = {1.f, 2.f, 3.f, 4.f};
+    std::cout << "add_one: " << (addOne ? addOne(41) : -1) << "\n";
+    std::cout << "sum: " << (sum ? sum(data, 4) : -1.f) << "\n";
+
+    // The mode can't be changed once the JIT is created.
+    bool passed = !engine->SetJitLazyCompilation(false);
+    std::cout << "Late configuration test: " << (passed ? "SUCCESS" : "FAILED") << "\n";
+
+    engine.reset();
+    ispc::Shutdown();
+    return 0;
+}
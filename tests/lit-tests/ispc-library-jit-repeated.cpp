@@ -0,0 +1,74 @@
+// This test verifies that repeated JIT compilations with one engine, which
+// reuse the parsed builtins and stdlib bitcode, produce working code.
+
+// RUN: %{cxx} -x c++ -std=c++17 -I%{ispc_include} %s -L%{ispc_lib} -lispc -o %t.bin
+// RUN: env LD_LIBRARY_PATH=%{ispc_lib} %t.bin | FileCheck %s
+
+// REQUIRES: LINUX_HOST
+
+// CHECK: kernel_0: 6
+// CHECK: kernel_1: 2
+// CHECK: kernel_2: 9
+// CHECK: Repeated JIT compilation test: SUCCESS
+
+// REQUIRES: ISPC_LIBRARY_JIT && !ASAN_RUN
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ispc/ispc.h"
+
+typedef float (*kernel_func_t)(float vin[], int count);
+
+int main() {
+    if (!ispc::Initialize()) {
+        std::cerr << "Failed to initialize ISPC\n";
+        return 1;
+    }
+
+    // Every kernel uses different stdlib functions, so every compilation links
+    // a different subset of the library.
+    const char *bodies[] = {
+        "return reduce_add(abs(vin[programIndex % count]) * (programIndex < count ? 1 : 0));",
+        "return reduce_max(clamp(vin[programIndex % count], 0.f, 4.f));",
+        "float sum = 0; foreach (i = 0 ... count) { sum += sqrt(vin[i] * vin[i]) + 1; } return reduce_add(sum);",
+    };
+
+    std::vector<std::string> args = {};
+    auto engine = ispc::ISPCEngine::CreateFromArgs(args);
+    if (!engine) {
+        std::cout << "Repeated JIT compilation test: FAILED (engine creation)\n";
+        return 1;
+    }
+
+    bool passed = true;
+    float data[] = {-1.f, 2.f, -3.f};
+    for (int k = 0; k < 3; ++k) {
+        std::string name = "kernel_" + std::to_string(k);
+        std::string file = "jit_repeated_" + std::to_string(k) + ".ispc";
+        std::ofstream out(file);
+        out << "export uniform float " << name << "(uniform float vin[], uniform int count) {\n";
+        out << "    " << bodies[k] << "\n";
+        out << "}\n";
+        out.close();
+
+        if (engine->CompileFromFileToJit(file) != 0) {
+            std::cout << name << ": FAILED (compilation error)\n";
+            passed = false;
+            continue;
+        }
+        auto func = reinterpret_cast<kernel_func_t>(engine->GetJitFunction(name));
+        if (!func) {
+            std::cout << name << ": FAILED (function not found)\n";
+            passed = false;
+            continue;
+        }
+        std::cout << name << ": " << func(data, 3) << "\n";
+    }
+
+    ispc::Shutdown();
+
+    std::cout << "Repeated JIT compilation test: " << (passed ? "SUCCESS" : "FAILED") << "\n";
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+// This test verifies that ISPC C++ library specializes JIT-compiled functions
+// for the given values of their uniform parameters and caches the results.
+
+// RUN: %{cxx} -x c++ -std=c++17 -I%{ispc_include} %s -L%{ispc_lib} -lispc -o %t.bin
+// RUN: env LD_LIBRARY_PATH=%{ispc_lib} %t.bin | FileCheck %s
+
+// REQUIRES: LINUX_HOST
+
+// CHECK: Specialized result: 2 4 6 0
+// CHECK: Generic result: 3 6 9 12
+// CHECK: Specialization cache test: SUCCESS
+// CHECK: Invalid parameter test: SUCCESS
+// CHECK: Disabled specialization test: SUCCESS
+
+// REQUIRES: ISPC_LIBRARY_JIT && !ASAN_RUN
+
+#include <iostream>
+#include <map>
+#include <string>
+#include "ispc/ispc.h"
+
+typedef void (*scale_func_t)(float vin[], float vout[], int count, float scale);
+
+static const char *source = "uniform int calls = 0;\n"
+                            "export void scale(uniform float vin[], uniform float vout[], uniform int count,\n"
+                            "                  uniform float scale) {\n"
+                            "    foreach (i = 0 ... count) {\n"
+                            "        vout[i] = vin[i] * scale;\n"
+                            "    }\n"
+                            "    calls++;\n"
+                            "}\n";
+
+static void print(const char *name, const float *v) {
+    std::cout << name << ": " << v[0] << " " << v[1] << " " << v[2] << " " << v[3] << "\n";
+}
+
+int main() {
+    if (!ispc::Initialize()) {
+        std::cerr << "Failed to initialize ISPC\n";
+        return 1;
+    }
+
+    auto engine = ispc::ISPCEngine::CreateFromArgs({});
+    if (!engine || !engine->SetJitSpecialization(true) || engine->CompileFromSourceToJit(source, "scale.ispc") != 0) {
+        std::cout << "Compilation: FAILED\n";
+        return 1;
+    }
+
+    float vin[] = {1.f, 2.f, 3.f, 4.f};
+
+    // Test 1: count and scale are fixed, the arguments passed for them are ignored.
+    auto specialized = reinterpret_cast<scale_func_t>(engine->GetSpecializedJitFunction("scale", {{2, 3}, {3, 2.f}}));
+    float vout[4] = {};
+    if (specialized) {
+        specialized(vin, vout, 100, 100.f);
+    }
+    print("Specialized result", vout);
+
+    // The original function is still available.
+    auto generic = reinterpret_cast<scale_func_t>(engine->GetJitFunction("scale"));
+    if (generic) {
+        generic(vin, vout, 4, 3.f);
+    }
+    print("Generic result", vout);
+
+    // Test 2: the same values return the cached function, different ones a new function.
+    void *cached = engine->GetSpecializedJitFunction("scale", {{3, 2.f}, {2, 3}});
+    void *other = engine->GetSpecializedJitFunction("scale", {{2, 3}, {3, 4.f}});
+    bool passed = specialized && cached == reinterpret_cast<void *>(specialized) && other && other != cached;
+    std::cout << "Specialization cache test: " << (passed ? "SUCCESS" : "FAILED") << "\n";
+
+    // Test 3: pointer parameters and missing parameters can't be specialized.
+    passed = engine->GetSpecializedJitFunction("scale", {{0, 1}}) == nullptr &&
+             engine->GetSpecializedJitFunction("scale", {{4, 1}}) == nullptr;
+    std::cout << "Invalid parameter test: " << (passed ? "SUCCESS" : "FAILED") << "\n";
+    engine.reset();
+
+    // Test 4: without SetJitSpecialization(true) the bitcode isn't kept and specialization fails.
+    engine = ispc::ISPCEngine::CreateFromArgs({});
+    passed = engine && engine->CompileFromSourceToJit(source, "scale.ispc") == 0 &&
+             engine->GetJitFunction("scale") != nullptr &&
+             engine->GetSpecializedJitFunction("scale", {{2, 3}}) == nullptr;
+    std::cout << "Disabled specialization test: " << (passed ? "SUCCESS" : "FAILED") << "\n";
+
+    engine.reset();
+    ispc::Shutdown();
+    return 0;
+}
@@ -0,0 +1,74 @@
+// This test verifies that ISPC C++ library compiles source code from memory,
+// resolving includes from the provided in-memory files, both to JIT and to
+// an object file.
+
+// RUN: %{cxx} -x c++ -std=c++17 -I%{ispc_include} %s -L%{ispc_lib} -lispc -o %t.bin
+// RUN: rm -rf %t.dir && mkdir -p %t.dir && cd %t.dir
+// RUN: env LD_LIBRARY_PATH=%{ispc_lib} %t.bin | FileCheck %s
+
+// REQUIRES: LINUX_HOST
+
+// CHECK: In-memory JIT compilation test: SUCCESS
+// CHECK: In-memory object compilation test: SUCCESS
+// CHECK: Missing include test: SUCCESS
+// CHECK-NOT: FAILED
+
+// REQUIRES: ISPC_LIBRARY_JIT && !ASAN_RUN
+
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "ispc/ispc.h"
+
+typedef void (*scale_func_t)(float vin[], float vout[], int count);
+
+static const char *source = "#include \"scale.isph\"\n"
+                            "export void scale(uniform float vin[], uniform float vout[], uniform int count) {\n"
+                            "    foreach (i = 0 ... count) {\n"
+                            "        vout[i] = vin[i] * SCALE;\n"
+                            "    }\n"
+                            "}\n";
+
+int main() {
+    if (!ispc::Initialize()) {
+        std::cerr << "Failed to initialize ISPC\n";
+        return 1;
+    }
+
+    std::map<std::string, std::string> includes = {{"scale.isph", "#define SCALE 3.0f\n"}};
+
+    // Test 1: compile to JIT and run the function.
+    {
+        auto engine = ispc::ISPCEngine::CreateFromArgs({});
+        bool ok = engine && engine->CompileFromSourceToJit(source, "kernel.ispc", includes) == 0;
+        auto func = ok ? reinterpret_cast<scale_func_t>(engine->GetJitFunction("scale")) : nullptr;
+        float vin[] = {1.f, 2.f, 3.f}, vout[3] = {};
+        if (func) {
+            func(vin, vout, 3);
+        }
+        bool passed = func && vout[0] == 3.f && vout[1] == 6.f && vout[2] == 9.f;
+        std::cout << "In-memory JIT compilation test: " << (passed ? "SUCCESS" : "FAILED") << "\n";
+    }
+
+    // Test 2: compile to an object file in memory.
+    {
+        auto engine = ispc::ISPCEngine::CreateFromArgs({"--target=host"});
+        std::vector<char> object;
+        bool ok = engine && engine->CompileFromSourceToObject(source, "kernel.ispc", object, includes) == 0;
+        bool passed = ok && object.size() > 4 && std::memcmp(object.data(), "\x7f" "ELF", 4) == 0;
+        std::cout << "In-memory object compilation test: " << (passed ? "SUCCESS" : "FAILED") << "\n";
+    }
+
+    // Test 3: the includes are not found without the in-memory files.
+    {
+        auto engine = ispc::ISPCEngine::CreateFromArgs({});
+        std::vector<char> object;
+        bool passed = engine && engine->CompileFromSourceToObject(source, "kernel.ispc", object) != 0;
+        std::cout << "Missing include test: " << (passed ? "SUCCESS" : "FAILED") << "\n";
+    }
+
+    ispc::Shutdown();
+    return 0;
+}
@@ -2,8 +2,10 @@
 
 ; CHECK-PRINT: Module passes:
 ; CHECK-PRINT-NEXT:   remove-persistent-funcs
+; CHECK-PRINT-NEXT:   specialize-uniform-args
 ; CHECK-PRINT-NEXT: Function passes:
 ; CHECK-PRINT-NEXT:   gather-coalesce
+; CHECK-PRINT-NEXT:   gather-scatter-versioning
 ; CHECK-PRINT-NEXT:   improve-memory-ops
 ; CHECK-PRINT-NEXT:   instruction-simplify
 ; CHECK-PRINT-NEXT:   intrinsics-opt
@@ -14,6 +16,8 @@
 ; CHECK-PRINT-NEXT:   replace-masked-memory-ops
 ; CHECK-PRINT-NEXT:   replace-pseudo-memory-ops
 ; CHECK-PRINT-NEXT:   replace-stdlib-shift
+; CHECK-PRINT-NEXT:   scalarize
+; CHECK-PRINT-NEXT:   scatter-coalesce
 
 ; RUN: not %{ispc-opt} --passes=unknown %s -o - 2>&1 | FileCheck --check-prefix=CHECK-UNKNOWN %s
 ; CHECK-UNKNOWN: Error: Unknown pass: unknown